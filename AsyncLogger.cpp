@@ -0,0 +1,191 @@
+#include "AsyncLogger.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const size_t BUFFER_CAPACITY{16384};
+
+// Indexed by LogFormat; each {} takes the next argument.
+const char* const FORMATS[]{
+    "Deposited {} {}. New balance: {} {}",
+    "Withdrawn {} {}. New balance: {} {}",
+    "Insufficient funds. Cannot withdraw {} {}",
+    "Cannot buy {}. Unknown asset.",
+    "Updated portfolio with buy of {} shares of {} at {}",
+    "Cannot sell {} shares of {}. Insufficient quantity in portfolio.",
+    "Portfolio updated with sale of {} shares of {} at {}. Realized PnL: {}",
+    "Order not processed. Insufficient funds.",
+    "New order for {}: {} ({}) price {} quantity {} total {}",
+};
+
+static_assert(sizeof(FORMATS) / sizeof(FORMATS[0]) == static_cast<size_t>(LogFormat::Count),
+              "every LogFormat needs a format string");
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO ";
+        case LogLevel::Warning: return "WARN ";
+        case LogLevel::Error: return "ERROR";
+        default: return "";
+    }
+}
+
+void appendArg(const LogArg& arg, string& text) {
+    char buffer[32];
+    switch (arg.type) {
+        case LogArgType::Integer: {
+            int64_t i;
+            memcpy(&i, arg.data, sizeof(i));
+            snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(i));
+            text += buffer;
+            break;
+        }
+        case LogArgType::Real: {
+            double d;
+            memcpy(&d, arg.data, sizeof(d));
+            snprintf(buffer, sizeof(buffer), "%g", d);
+            text += buffer;
+            break;
+        }
+        case LogArgType::Text:
+            text.append(arg.data, strnlen(arg.data, sizeof(arg.data)));
+            break;
+        default:
+            break;
+    }
+}
+}
+
+LogBuffer::LogBuffer(size_t capacity) {
+    size_t size{1};
+    while (size < capacity) size *= 2;
+    slots.resize(size);
+    mask = size - 1;
+}
+
+bool LogBuffer::push(const LogRecord& record) {
+    size_t t{tail.load(memory_order_relaxed)};
+    if (t - head.load(memory_order_acquire) > mask) return false;
+    slots[t & mask] = record;
+    tail.store(t + 1, memory_order_release);
+    return true;
+}
+
+bool LogBuffer::pop(LogRecord& record) {
+    size_t h{head.load(memory_order_relaxed)};
+    if (h == tail.load(memory_order_acquire)) return false;
+    record = slots[h & mask];
+    head.store(h + 1, memory_order_release);
+    return true;
+}
+
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::AsyncLogger() : output(&cout) {
+    writer = thread([this] { run(); });
+}
+
+AsyncLogger::~AsyncLogger() {
+    running.store(false, memory_order_release);
+    if (writer.joinable()) writer.join();
+}
+
+void AsyncLogger::setOutput(ostream& stream) {
+    flush();
+    output.store(&stream, memory_order_release);
+}
+
+void AsyncLogger::setText(LogArg& arg, string_view text) {
+    arg.type = LogArgType::Text;
+    size_t length{min(text.size(), sizeof(arg.data) - 1)};
+    memcpy(arg.data, text.data(), length);
+    arg.data[length] = '\0';
+}
+
+LogBuffer& AsyncLogger::localBuffer() {
+    thread_local LogBuffer* buffer{nullptr};
+    if (!buffer) {
+        lock_guard<mutex> lock(buffersMutex);
+        buffers.push_back(make_unique<LogBuffer>(BUFFER_CAPACITY));
+        buffer = buffers.back().get();
+    }
+    return *buffer;
+}
+
+void AsyncLogger::submit(LogRecord& record) {
+    record.timestamp = chrono::duration_cast<chrono::nanoseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+    if (localBuffer().push(record)) {
+        submitted.fetch_add(1, memory_order_relaxed);
+    } else {
+        dropped.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void AsyncLogger::flush() {
+    uint64_t target{submitted.load(memory_order_relaxed)};
+    while (written.load(memory_order_acquire) < target && writer.joinable()) {
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+}
+
+void AsyncLogger::format(const LogRecord& record, string& text) {
+    time_t seconds{static_cast<time_t>(record.timestamp / 1000000000)};
+    char prefix[48];
+    size_t length{strftime(prefix, sizeof(prefix), "%H:%M:%S", localtime(&seconds))};
+    snprintf(prefix + length, sizeof(prefix) - length, ".%03d %s ",
+             static_cast<int>((record.timestamp / 1000000) % 1000), levelName(record.level));
+    text += prefix;
+
+    const char* pattern{FORMATS[static_cast<size_t>(record.format)]};
+    size_t arg{0};
+    for (const char* c = pattern; *c; ++c) {
+        if (c[0] == '{' && c[1] == '}') {
+            if (arg < record.argCount) appendArg(record.args[arg++], text);
+            ++c;
+        } else {
+            text += *c;
+        }
+    }
+    text += '\n';
+}
+
+size_t AsyncLogger::drain(string& text) {
+    size_t count{0};
+    LogRecord record;
+    lock_guard<mutex> lock(buffersMutex);
+    for (auto& buffer : buffers) {
+        while (buffer->pop(record)) {
+            format(record, text);
+            ++count;
+        }
+    }
+    return count;
+}
+
+void AsyncLogger::run() {
+    string text;
+    while (true) {
+        bool stopping{!running.load(memory_order_acquire)};
+        text.clear();
+        size_t count{drain(text)};
+        if (count > 0) {
+            ostream& out{*output.load(memory_order_acquire)};
+            out << text;
+            out.flush();
+            written.fetch_add(count, memory_order_release);
+        } else if (stopping) {
+            break;
+        } else {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+}
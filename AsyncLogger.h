@@ -0,0 +1,157 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel : uint8_t {
+    Debug = 0,
+    Info = 1,
+    Warning = 2,
+    Error = 3,
+    Off = 4
+};
+
+// Every message the trading path can emit. Producers only send the id and the raw
+// arguments; the text lives in the format table in AsyncLogger.cpp.
+enum class LogFormat : uint16_t {
+    Deposit,
+    Withdrawal,
+    WithdrawalRejected,
+    BuyUnknownAsset,
+    BuyUpdated,
+    SellRejected,
+    SellUpdated,
+    BuyNotProcessed,
+    SimulatedOrder,
+    Count
+};
+
+enum class LogArgType : uint8_t {
+    None,
+    Integer,
+    Real,
+    Text
+};
+
+// Numbers are stored raw; text is truncated to 14 characters (symbols, currencies, sides).
+struct LogArg {
+    LogArgType type;
+    char data[15];
+};
+
+const size_t LOG_MAX_ARGS{6};
+
+struct LogRecord {
+    int64_t timestamp;
+    LogFormat format;
+    LogLevel level;
+    uint8_t argCount;
+    uint32_t reserved;
+    LogArg args[LOG_MAX_ARGS];
+};
+
+static_assert(std::is_trivially_copyable<LogRecord>::value, "LogRecord is copied into ring slots");
+
+// Single-producer/single-consumer ring of LogRecords. The owning thread pushes, the
+// logger thread pops; head and tail sit on separate cache lines.
+class LogBuffer {
+public:
+    explicit LogBuffer(size_t capacity);
+
+    bool push(const LogRecord& record);
+    bool pop(LogRecord& record);
+
+private:
+    std::vector<LogRecord> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+// Producers append binary records to their own thread's LogBuffer (registered on first
+// use) without locks or formatting; one background thread formats and writes them.
+// A full buffer drops the record and counts it rather than blocking the producer.
+class AsyncLogger {
+public:
+    static AsyncLogger& instance();
+    ~AsyncLogger();
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    void setLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+    LogLevel getLevel() const { return minLevel.load(std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= getLevel(); }
+
+    // Redirects output (default std::cout); the stream must outlive the logger.
+    void setOutput(std::ostream& stream);
+    // Blocks until every record pushed before the call has been written.
+    void flush();
+    uint64_t droppedRecords() const { return dropped.load(std::memory_order_relaxed); }
+
+    template <typename... Args>
+    void log(LogLevel level, LogFormat format, const Args&... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many log arguments");
+        if (!enabled(level)) return;
+        LogRecord record;
+        record.format = format;
+        record.level = level;
+        record.argCount = 0;
+        (setArg(record.args[record.argCount++], args), ...);
+        submit(record);
+    }
+
+private:
+    AsyncLogger();
+
+    std::atomic<LogLevel> minLevel{LogLevel::Info};
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<std::ostream*> output;
+    std::mutex buffersMutex;
+    std::vector<std::unique_ptr<LogBuffer>> buffers;
+    std::thread writer;
+
+    LogBuffer& localBuffer();
+    void submit(LogRecord& record);
+    void run();
+    size_t drain(std::string& text);
+    static void format(const LogRecord& record, std::string& text);
+
+    template <typename T>
+    static void setArg(LogArg& arg, const T& value) {
+        if constexpr (std::is_floating_point<T>::value) {
+            arg.type = LogArgType::Real;
+            double d{static_cast<double>(value)};
+            std::memcpy(arg.data, &d, sizeof(d));
+        } else if constexpr (std::is_integral<T>::value) {
+            arg.type = LogArgType::Integer;
+            int64_t i{static_cast<int64_t>(value)};
+            std::memcpy(arg.data, &i, sizeof(i));
+        } else {
+            setText(arg, std::string_view(value));
+        }
+    }
+    static void setText(LogArg& arg, std::string_view text);
+};
+
+// Building with LOB_LOGGING_DISABLED removes every call; arguments sit in an unevaluated
+// operand so nothing runs and no unused-variable warnings appear.
+#ifdef LOB_LOGGING_DISABLED
+#define LOB_LOG(level, format, ...) ((void)sizeof((AsyncLogger::instance().log(level, format, ##__VA_ARGS__), 0)))
+#else
+#define LOB_LOG(level, format, ...) AsyncLogger::instance().log(level, format, ##__VA_ARGS__)
+#endif
+
+#endif
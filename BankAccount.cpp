@@ -1,4 +1,6 @@
 #include "BankAccount.h"
+#include "Journal.h"
+#include "AsyncLogger.h"
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
@@ -6,33 +8,50 @@
 using namespace std;
 
 BankAccount::BankAccount(double initialBalance, const string &currency) 
-    :balance(initialBalance), currency(currency) {}
+    :ownedLedger(new Ledger(0)), ledger(ownedLedger.get()), accountId(ownedLedger->addAccount(initialBalance)),
+     currency(currency), journal(nullptr), historyLimit(0) {}
+
+BankAccount::BankAccount(Ledger &sharedLedger, uint32_t id, const string &currency)
+    :ledger(&sharedLedger), accountId(id), currency(currency), journal(nullptr), historyLimit(0) {}
 
 bool BankAccount::deposit(double amount, const string &dateTime) {
-    if (amount <= 0) return false;
-    balance += amount;
+    if (!ledger->credit(accountId, amount)) return false;
+    double balance = getBalance();
     logTransaction("Deposit", amount, dateTime);
-    cout << "Deposited"<< amount << currency << ". New balance: " << balance << currency << endl;
+    LOB_LOG(LogLevel::Info, LogFormat::Deposit, amount, currency, balance, currency);
     return true;
 }
 
 bool BankAccount::withdraw(double amount, const std::string &dateTime) {
     if (amount <= 0) return false;
-    if (amount > balance) {
-        cout << "Insufficient funds. Cannot withdraw" << amount << currency << endl;
+    if (!ledger->debit(accountId, amount)) {
+        LOB_LOG(LogLevel::Warning, LogFormat::WithdrawalRejected, amount, currency);
         return false;
     }
-    balance -= amount;
+    double balance = getBalance();
     logTransaction("Withdrawal", amount, dateTime);
-    cout << "Withdrawn" << amount << currency << ". New balance: " << balance << currency << endl;
+    LOB_LOG(LogLevel::Info, LogFormat::Withdrawal, amount, currency, balance, currency);
     return true;
 }
 
 double BankAccount::getBalance() const {
-    return balance;
+    return ledger->cash(accountId);
+}
+
+void BankAccount::attachJournal(Journal *j, size_t tailSize) {
+    journal = j;
+    historyLimit = tailSize;
+    while (transactionHistory.size() > historyLimit) transactionHistory.pop_front();
 }
 
 void BankAccount:: logTransactionsToCSV(const std::string &filename) const{
+    if (journal) {
+        journal->flush();
+        if (JournalReader(journal->getPath()).exportTransactionsCSV(filename)) {
+            cout << "Bank Account transaction logged to " << filename << endl;
+        }
+        return;
+    }
     ofstream file(filename);
     if (!file.is_open()){
         cerr << "Error opening bank account CSV file." << endl;
@@ -46,6 +65,11 @@ void BankAccount:: logTransactionsToCSV(const std::string &filename) const{
     cout << "Bank Account transaction logged to " << filename << endl;
 }
 void BankAccount::logTransaction(const std::string &type, double amount, const std::string &dateTime) {
+    double balance = getBalance();
     Transaction t = {dateTime, type, amount, balance};
     transactionHistory.push_back(t);
+    if (journal) {
+        journal->recordTransaction(type, amount, balance, dateTime);
+        if (transactionHistory.size() > historyLimit) transactionHistory.pop_front();
+    }
 }
\ No newline at end of file
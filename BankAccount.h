@@ -3,6 +3,13 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <cstdint>
+
+#include "Ledger.h"
+
+class Journal;
 
 using namespace std;
 
@@ -16,15 +23,23 @@ struct Transaction {
 class BankAccount {
 public : 
     BankAccount(double initialBalance, const std::string &currency);
+    BankAccount(Ledger &ledger, uint32_t accountId, const std::string &currency);
     bool deposit(double amount, const std::string &dateTime);
     bool withdraw(double amount, const std::string &dateTime);
     double getBalance() const;
     void logTransactionsToCSV(const std::string &filename) const;
+    void attachJournal(Journal *journal, size_t tailSize = 1024);
+    Ledger &getLedger() const { return *ledger; }
+    uint32_t getAccountId() const { return accountId; }
 
 private:
-    double balance;
+    unique_ptr<Ledger> ownedLedger;
+    Ledger *ledger;
+    uint32_t accountId;
     string currency;
-    vector<Transaction> transactionHistory;
+    deque<Transaction> transactionHistory;
+    Journal *journal;
+    size_t historyLimit;
 
     void logTransaction(const string &type, double amount, const string &dateTime);
 };
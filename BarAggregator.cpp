@@ -0,0 +1,93 @@
+#include "BarAggregator.h"
+#include "Journal.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const int64_t NANOS_PER_SECOND{1000000000};
+
+int64_t bucketStart(int64_t time, int64_t interval) {
+    int64_t start{time - time % interval};
+    return (time % interval < 0) ? start - interval : start;
+}
+}
+
+BarAggregator::BarAggregator(const vector<int>& intervalSeconds, size_t barCapacity)
+    : intervals(intervalSeconds), capacity(barCapacity) {
+    intervals.erase(remove_if(intervals.begin(), intervals.end(), [](int s) { return s <= 0; }), intervals.end());
+}
+
+vector<RingBuffer<Bar>>& BarAggregator::seriesFor(const string& asset) {
+    auto it{series.find(asset)};
+    if (it == series.end()) {
+        it = series.emplace(asset, vector<RingBuffer<Bar>>(intervals.size(), RingBuffer<Bar>(capacity))).first;
+    }
+    return it->second;
+}
+
+void BarAggregator::onExecution(const string& asset, const Execution& execution) {
+    auto& assetSeries{seriesFor(asset)};
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        auto& bars{assetSeries[i]};
+        int64_t start{bucketStart(execution.timestamp, intervals[i] * NANOS_PER_SECOND)};
+
+        // Late executions are folded into the current bar rather than reopening an old one.
+        if (bars.empty() || start > bars.back().start) {
+            if (bars.full()) bars.pop();
+            Bar bar;
+            bar.start = start;
+            bar.open = execution.price;
+            bar.high = execution.price;
+            bar.low = execution.price;
+            bars.push(bar);
+        }
+
+        Bar& bar{bars.back()};
+        bar.high = max(bar.high, execution.price);
+        bar.low = min(bar.low, execution.price);
+        bar.close = execution.price;
+        bar.volume += execution.quantity;
+        bar.notional += execution.price * execution.quantity;
+        bar.vwap = bar.volume > 0 ? bar.notional / bar.volume : execution.price;
+        bar.trades++;
+    }
+}
+
+vector<Bar> BarAggregator::lastBars(const string& asset, int intervalSeconds, size_t k) const {
+    vector<Bar> result;
+    auto it{series.find(asset)};
+    auto interval{find(intervals.begin(), intervals.end(), intervalSeconds)};
+    if (it == series.end() || interval == intervals.end()) return result;
+
+    const auto& bars{it->second[interval - intervals.begin()]};
+    size_t n{min(k, bars.size())};
+    result.reserve(n);
+    for (size_t i = bars.size() - n; i < bars.size(); ++i) {
+        result.push_back(bars.at(i));
+    }
+    return result;
+}
+
+bool BarAggregator::exportCSV(const string& filename) const {
+    ofstream file(filename);
+    if (!file.is_open()) {
+        cerr << "Error: file access denied for " << filename << "\n";
+        return false;
+    }
+    file << "Asset,IntervalSeconds,Start,Open,High,Low,Close,Volume,VWAP,Trades\n";
+    for (const auto& [asset, assetSeries] : series) {
+        for (size_t i = 0; i < intervals.size(); ++i) {
+            const auto& bars{assetSeries[i]};
+            for (size_t j = 0; j < bars.size(); ++j) {
+                const Bar& bar{bars.at(j)};
+                file << asset << "," << intervals[i] << "," << formatEpochNanos(bar.start) << ","
+                     << bar.open << "," << bar.high << "," << bar.low << "," << bar.close << ","
+                     << bar.volume << "," << bar.vwap << "," << bar.trades << "\n";
+            }
+        }
+    }
+    return true;
+}
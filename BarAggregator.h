@@ -0,0 +1,47 @@
+#ifndef BAR_AGGREGATOR_H
+#define BAR_AGGREGATOR_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MarketAnalytics.h"
+#include "OrderBookManager.h"
+
+struct Bar {
+    int64_t start{0};
+    double open{0.0};
+    double high{0.0};
+    double low{0.0};
+    double close{0.0};
+    double volume{0.0};
+    double notional{0.0};
+    double vwap{0.0};
+    int trades{0};
+};
+
+// OHLCV bars for several intervals at once, built from executions as they happen.
+// Each asset/interval keeps the last `capacity` bars in a preallocated ring; the newest
+// bar is the one still being built.
+class BarAggregator {
+public:
+    explicit BarAggregator(const std::vector<int>& intervalSeconds = {1, 60, 300}, size_t capacity = 1024);
+
+    void onExecution(const std::string& asset, const Execution& execution);
+
+    // Oldest first; fewer than k bars when the history is shorter.
+    std::vector<Bar> lastBars(const std::string& asset, int intervalSeconds, size_t k) const;
+    const std::vector<int>& getIntervals() const { return intervals; }
+
+    bool exportCSV(const std::string& filename) const;
+
+private:
+    std::vector<int> intervals;
+    size_t capacity;
+    std::map<std::string, std::vector<RingBuffer<Bar>>> series;
+
+    std::vector<RingBuffer<Bar>>& seriesFor(const std::string& asset);
+};
+
+#endif
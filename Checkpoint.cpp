@@ -0,0 +1,311 @@
+#include "Checkpoint.h"
+#include "MappedFile.h"
+#include "OrderGenerator.h"
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+using namespace std;
+
+static_assert(is_trivially_copyable<OrderBookStatistics>::value, "statistics are copied byte-for-byte");
+static_assert(is_trivially_copyable<AnalyticsState>::value && is_trivially_copyable<TradeSample>::value &&
+                  is_trivially_copyable<SpreadSample>::value,
+              "analytics are copied byte-for-byte");
+static_assert(is_trivially_copyable<DepthState>::value, "depth indexes are copied byte-for-byte");
+
+namespace {
+const char CHECKPOINT_MAGIC[8]{'L', 'O', 'B', 'C', 'K', 'P', 'T', '1'};
+
+template <typename T>
+void put(vector<char>& buffer, const T& value) {
+    const char* bytes{reinterpret_cast<const char*>(&value)};
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+bool take(const char*& cursor, const char* end, T& value) {
+    if (static_cast<size_t>(end - cursor) < sizeof(T)) return false;
+    memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+template <typename Book>
+void putLevels(vector<char>& buffer, const Book& book) {
+    for (const auto& [price, entry] : book) {
+        CheckpointLevel level{entry.id, price, entry.quantity,
+                              chrono::duration_cast<chrono::nanoseconds>(entry.timestamp.time_since_epoch()).count(),
+                              entry.levelId, entry.queuedQuantity, entry.executedQuantity};
+        put(buffer, level);
+    }
+}
+
+bool takeLevels(const char*& cursor, const char* end, uint64_t count, vector<OrderBookEntry>& out) {
+    if (static_cast<uint64_t>(end - cursor) / sizeof(CheckpointLevel) < count) return false;
+    out.clear();
+    out.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        CheckpointLevel level;
+        take(cursor, end, level);
+        chrono::system_clock::time_point timestamp{
+            chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(level.timestamp))};
+        out.push_back(OrderBookEntry{static_cast<int>(level.id), level.price, level.quantity, timestamp, level.levelId,
+                                     level.queuedQuantity, level.executedQuantity});
+    }
+    return true;
+}
+
+template <typename Sample>
+void putSamples(vector<char>& buffer, const RingBuffer<Sample>& samples) {
+    for (size_t i = 0; i < samples.size(); ++i) {
+        put(buffer, samples.at(i));
+    }
+}
+
+template <typename Sample>
+void takeSamples(const char*& cursor, const char* end, uint64_t count, vector<Sample>& out) {
+    out.clear();
+    out.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        Sample sample;
+        take(cursor, end, sample);
+        out.push_back(sample);
+    }
+}
+
+uint64_t treeNodes(const DepthState& state) {
+    return state.buckets > 0 ? state.buckets + 1 : 0;
+}
+
+void putDepth(vector<char>& buffer, const DepthIndex& depth) {
+    put(buffer, depth.getState());
+    for (double value : depth.getQuantityTree()) put(buffer, value);
+    for (double value : depth.getNotionalTree()) put(buffer, value);
+}
+
+void takeDepth(const char*& cursor, const char* end, DepthIndex& depth) {
+    DepthState state;
+    take(cursor, end, state);
+    vector<double> quantities(treeNodes(state));
+    vector<double> notionals(treeNodes(state));
+    for (double& value : quantities) take(cursor, end, value);
+    for (double& value : notionals) take(cursor, end, value);
+    depth.restore(state, quantities, notionals);
+}
+
+template <typename Stops>
+void putStops(vector<char>& buffer, const Stops& stops) {
+    for (const auto& [trigger, stop] : stops) {
+        put(buffer, CheckpointStop{trigger, stop.limitPrice, stop.quantity, stop.timestamp, stop.expireTime, stop.id,
+                                   stop.isBuy ? uint8_t{1} : uint8_t{0}, stop.type, stop.timeInForce, 0});
+    }
+}
+
+void takeStops(const char*& cursor, const char* end, uint64_t count, vector<pair<double, StopOrder>>& out) {
+    out.clear();
+    out.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        CheckpointStop stop;
+        take(cursor, end, stop);
+        out.emplace_back(stop.triggerPrice, StopOrder{stop.id, stop.isBuy != 0, stop.type, stop.timeInForce,
+                                                      stop.limitPrice, stop.quantity, stop.timestamp, stop.expireTime});
+    }
+}
+
+void takeTimedOrders(const char*& cursor, const char* end, uint64_t count, vector<TimedOrder>& out) {
+    out.clear();
+    out.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        CheckpointTimedOrder order;
+        take(cursor, end, order);
+        out.push_back(TimedOrder{static_cast<int>(order.id), order.isBuy != 0, order.price, order.quantity,
+                                 order.queuePosition, order.levelId, order.expiry});
+    }
+}
+}
+
+bool saveCheckpoint(const string& path, const OrderBookManager& manager, const Portfolio& portfolio,
+                    const BankAccount& account, uint64_t journalRecords) {
+    const auto& statistics{manager.getStatistics()};
+    const auto& bidBooks{manager.getBidBooks()};
+    const auto& askBooks{manager.getAskBooks()};
+
+    CheckpointHeader header{};
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.statisticsSize = sizeof(OrderBookStatistics);
+    header.assetCount = static_cast<uint32_t>(statistics.size());
+    header.portfolioAssets = static_cast<uint32_t>(ASSETS.size());
+    header.nextOrderId = manager.getNextOrderId();
+    header.journalRecords = journalRecords;
+    header.levelSequence = manager.getLevelSequence();
+    header.engineClock = manager.getClock();
+    header.cashBalance = account.getBalance();
+
+    vector<char> buffer;
+    put(buffer, header);
+
+    static const BidBook emptyBids;
+    static const AskBook emptyAsks;
+    const MarketAnalytics noAnalytics{manager.getAnalyticsConfig()};
+    const DepthIndex noDepth;
+    for (const auto& [asset, stats] : statistics) {
+        auto bid{bidBooks.find(asset)};
+        auto ask{askBooks.find(asset)};
+        const BidBook& bids{bid != bidBooks.end() ? bid->second : emptyBids};
+        const AskBook& asks{ask != askBooks.end() ? ask->second : emptyAsks};
+
+        CheckpointAsset assetHeader{};
+        strncpy(assetHeader.symbol, asset.c_str(), sizeof(assetHeader.symbol) - 1);
+        const MarketAnalytics* assetAnalytics{manager.getAnalytics(asset)};
+        if (!assetAnalytics) assetAnalytics = &noAnalytics;
+        assetHeader.tradeSamples = assetAnalytics->getTrades().size();
+        assetHeader.spreadSamples = assetAnalytics->getSpreads().size();
+        assetHeader.bidLevels = bids.size();
+        assetHeader.askLevels = asks.size();
+        vector<TimedOrder> timed{manager.getTimedOrders(asset)};
+        assetHeader.timedOrders = timed.size();
+        const StopIndex* stops{manager.getStopIndex(asset)};
+        assetHeader.buyStops = stops ? stops->buys.size() : 0;
+        assetHeader.sellStops = stops ? stops->sells.size() : 0;
+        put(buffer, assetHeader);
+        put(buffer, stats);
+        put(buffer, assetAnalytics->getState());
+        putSamples(buffer, assetAnalytics->getTrades());
+        putSamples(buffer, assetAnalytics->getSpreads());
+        for (bool side : {true, false}) {
+            const DepthIndex* depth{manager.getDepth(asset, side)};
+            putDepth(buffer, depth ? *depth : noDepth);
+        }
+        putLevels(buffer, bids);
+        putLevels(buffer, asks);
+        for (const auto& order : timed) {
+            put(buffer, CheckpointTimedOrder{order.id, order.price, order.quantity, order.queuePosition, order.levelId,
+                                             order.expiry, order.isBuy ? uint8_t{1} : uint8_t{0}, {}});
+        }
+        if (stops) {
+            putStops(buffer, stops->buys);
+            putStops(buffer, stops->sells);
+        }
+    }
+
+    for (const auto& stock : ASSETS) {
+        Holding h{portfolio.getHolding(stock)};
+        put(buffer, CheckpointHolding{h.quantity, h.averagePrice, portfolio.getRealizedPnL(stock), h.marketPrice});
+    }
+
+    // Write to a side file and rename so a crash mid-save never leaves a torn image.
+    string tmpPath{path + ".tmp"};
+    FILE* file{fopen(tmpPath.c_str(), "wb")};
+    if (!file) return false;
+    bool written{fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size()};
+    written = (fclose(file) == 0) && written;
+    if (!written) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+#ifdef _WIN32
+    remove(path.c_str());
+#endif
+    return rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+bool restoreCheckpoint(const string& path, OrderBookManager& manager, Portfolio& portfolio,
+                       BankAccount& account, CheckpointInfo* info) {
+    MappedRegion region;
+    if (!region.open(path)) return false;
+
+    const char* cursor{region.data()};
+    const char* end{region.data() + region.size()};
+
+    CheckpointHeader header;
+    if (!take(cursor, end, header) || memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != CHECKPOINT_VERSION || header.statisticsSize != sizeof(OrderBookStatistics)) {
+        return false;
+    }
+
+    // Validate the whole image before touching any engine state.
+    const char* scan{cursor};
+    for (uint32_t i = 0; i < header.assetCount; ++i) {
+        CheckpointAsset assetHeader;
+        if (!take(scan, end, assetHeader)) return false;
+        uint64_t remaining{static_cast<uint64_t>(end - scan)};
+        if (remaining < sizeof(OrderBookStatistics) + sizeof(AnalyticsState)) return false;
+        remaining -= sizeof(OrderBookStatistics) + sizeof(AnalyticsState);
+        if (remaining / sizeof(TradeSample) < assetHeader.tradeSamples) return false;
+        remaining -= assetHeader.tradeSamples * sizeof(TradeSample);
+        if (remaining / sizeof(SpreadSample) < assetHeader.spreadSamples) return false;
+        remaining -= assetHeader.spreadSamples * sizeof(SpreadSample);
+        for (int side = 0; side < 2; ++side) {
+            const char* at{end - remaining};
+            DepthState depth;
+            if (!take(at, end, depth)) return false;
+            remaining -= sizeof(DepthState);
+            if (!(depth.tick > 0) || depth.buckets > remaining || remaining / (2 * sizeof(double)) < treeNodes(depth)) {
+                return false;
+            }
+            remaining -= treeNodes(depth) * 2 * sizeof(double);
+        }
+        if (remaining / sizeof(CheckpointLevel) < assetHeader.bidLevels + assetHeader.askLevels) return false;
+        remaining -= (assetHeader.bidLevels + assetHeader.askLevels) * sizeof(CheckpointLevel);
+        if (remaining / sizeof(CheckpointTimedOrder) < assetHeader.timedOrders) return false;
+        remaining -= assetHeader.timedOrders * sizeof(CheckpointTimedOrder);
+        if (remaining / sizeof(CheckpointStop) < assetHeader.buyStops + assetHeader.sellStops) return false;
+        remaining -= (assetHeader.buyStops + assetHeader.sellStops) * sizeof(CheckpointStop);
+        scan = end - remaining;
+    }
+    if (static_cast<uint64_t>(end - scan) < header.portfolioAssets * sizeof(CheckpointHolding)) return false;
+
+    vector<OrderBookEntry> bids;
+    vector<OrderBookEntry> asks;
+    vector<TradeSample> trades;
+    vector<SpreadSample> spreads;
+    DepthIndex bidDepth;
+    DepthIndex askDepth;
+    vector<TimedOrder> timed;
+    vector<pair<double, StopOrder>> stops;
+    size_t levelCount{0};
+    for (uint32_t i = 0; i < header.assetCount; ++i) {
+        CheckpointAsset assetHeader;
+        OrderBookStatistics stats;
+        AnalyticsState analytics;
+        take(cursor, end, assetHeader);
+        take(cursor, end, stats);
+        take(cursor, end, analytics);
+        takeSamples(cursor, end, assetHeader.tradeSamples, trades);
+        takeSamples(cursor, end, assetHeader.spreadSamples, spreads);
+        takeDepth(cursor, end, bidDepth);
+        takeDepth(cursor, end, askDepth);
+        takeLevels(cursor, end, assetHeader.bidLevels, bids);
+        takeLevels(cursor, end, assetHeader.askLevels, asks);
+        takeTimedOrders(cursor, end, assetHeader.timedOrders, timed);
+        takeStops(cursor, end, assetHeader.buyStops + assetHeader.sellStops, stops);
+        string asset(assetHeader.symbol, strnlen(assetHeader.symbol, sizeof(assetHeader.symbol)));
+        manager.restoreBook(asset, bids, asks, stats, timed, stops);
+        manager.restoreAnalytics(asset, analytics, trades, spreads);
+        manager.restoreDepth(asset, bidDepth, askDepth);
+        levelCount += bids.size() + asks.size();
+    }
+    manager.setNextOrderId(header.nextOrderId);
+    manager.setLevelSequence(header.levelSequence);
+    manager.setClock(header.engineClock);
+
+    Ledger& ledger{account.getLedger()};
+    ledger.setCash(account.getAccountId(), header.cashBalance);
+
+    Ledger& holdings{portfolio.getLedger()};
+    for (uint32_t i = 0; i < header.portfolioAssets; ++i) {
+        CheckpointHolding h;
+        take(cursor, end, h);
+        if (i >= ASSETS.size() || !holdings.isValid(portfolio.getAccountId(), i)) continue;
+        holdings.restorePosition(portfolio.getAccountId(), i, h.quantity, h.averagePrice, h.realizedPnL);
+        if (h.marketPrice > 0) portfolio.markToMarket(ASSETS[i], h.marketPrice);
+    }
+
+    if (info) {
+        info->journalRecords = header.journalRecords;
+        info->assetCount = header.assetCount;
+        info->levelCount = levelCount;
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+
+#include "OrderBookManager.h"
+#include "Portfolio.h"
+#include "BankAccount.h"
+
+// Binary engine image, version CHECKPOINT_VERSION:
+// [CheckpointHeader]
+// assetCount x ([CheckpointAsset][OrderBookStatistics]
+//               [AnalyticsState][TradeSample x tradeSamples][SpreadSample x spreadSamples]
+//               2 x ([DepthState][double x nodes][double x nodes])
+//               [CheckpointLevel x (bidLevels + askLevels)]
+//               [CheckpointTimedOrder x timedOrders][CheckpointStop x (buyStops + sellStops)])
+// portfolioAssets x [CheckpointHolding]
+// Levels are stored in book order so a restore appends them without any matching. They keep
+// their ids and queue totals, which DAY and GTT orders locate themselves by. Stops are stored in
+// trigger order. The analytics windows are stored oldest sample first, with their running sums.
+// The bid then ask depth indexes follow with both of their trees, nodes being buckets + 1, or
+// none while buckets is 0.
+const uint32_t CHECKPOINT_VERSION{5};
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t statisticsSize;
+    uint32_t assetCount;
+    uint32_t portfolioAssets;
+    int32_t nextOrderId;
+    uint32_t reserved;
+    uint64_t journalRecords;
+    uint64_t levelSequence;
+    int64_t engineClock;
+    double cashBalance;
+};
+
+struct CheckpointAsset {
+    char symbol[16];
+    uint64_t tradeSamples;
+    uint64_t spreadSamples;
+    uint64_t bidLevels;
+    uint64_t askLevels;
+    uint64_t timedOrders;
+    uint64_t buyStops;
+    uint64_t sellStops;
+};
+
+struct CheckpointLevel {
+    int64_t id;
+    double price;
+    double quantity;
+    int64_t timestamp;
+    uint64_t levelId;
+    double queuedQuantity;
+    double executedQuantity;
+};
+
+struct CheckpointTimedOrder {
+    int64_t id;
+    double price;
+    double quantity;
+    double queuePosition;
+    uint64_t levelId;
+    int64_t expiry;
+    uint8_t isBuy;
+    uint8_t reserved[7];
+};
+
+struct CheckpointStop {
+    double triggerPrice;
+    double limitPrice;
+    double quantity;
+    int64_t timestamp;
+    int64_t expireTime;
+    int32_t id;
+    uint8_t isBuy;
+    OrderType type;
+    TimeInForce timeInForce;
+    uint8_t reserved;
+};
+
+struct CheckpointHolding {
+    double quantity;
+    double averagePrice;
+    double realizedPnL;
+    double marketPrice;
+};
+
+struct CheckpointInfo {
+    uint64_t journalRecords{0};
+    size_t assetCount{0};
+    size_t levelCount{0};
+};
+
+// journalRecords is the journal length at save time; replay only what came after it.
+bool saveCheckpoint(const std::string& path, const OrderBookManager& manager, const Portfolio& portfolio,
+                    const BankAccount& account, uint64_t journalRecords = 0);
+
+bool restoreCheckpoint(const std::string& path, OrderBookManager& manager, Portfolio& portfolio,
+                       BankAccount& account, CheckpointInfo* info = nullptr);
+
+#endif
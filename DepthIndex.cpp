@@ -0,0 +1,178 @@
+#include "DepthIndex.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+const size_t INITIAL_BUCKETS{1024};
+// Prices further out than this many buckets share the edge bucket instead of growing the trees.
+const size_t MAX_BUCKETS{size_t{1} << 20};
+}
+
+DepthIndex::DepthIndex(double tickSize) : tick(tickSize > 0 ? tickSize : 0.01) {}
+
+int64_t DepthIndex::bucketOf(double price) const {
+    return llround(price / tick);
+}
+
+void DepthIndex::clear() {
+    fill(quantityTree.begin(), quantityTree.end(), 0.0);
+    fill(notionalTree.begin(), notionalTree.end(), 0.0);
+    quantity = 0.0;
+    notional = 0.0;
+}
+
+void DepthIndex::restore(const DepthState& state, const vector<double>& quantities, const vector<double>& notionals) {
+    tick = state.tick;
+    base = state.base;
+    buckets = static_cast<size_t>(state.buckets);
+    quantity = state.quantity;
+    notional = state.notional;
+    quantityTree = quantities;
+    notionalTree = notionals;
+}
+
+void DepthIndex::ensureRange(int64_t bucket) {
+    if (buckets == 0) {
+        buckets = INITIAL_BUCKETS;
+        base = bucket - static_cast<int64_t>(buckets / 2);
+        quantityTree.assign(buckets + 1, 0.0);
+        notionalTree.assign(buckets + 1, 0.0);
+        return;
+    }
+    int64_t top{base + static_cast<int64_t>(buckets) - 1};
+    if (bucket >= base && bucket <= top) return;
+
+    int64_t lo{min(base, bucket)};
+    int64_t hi{max(top, bucket)};
+    size_t span{static_cast<size_t>(hi - lo + 1)};
+    if (buckets >= MAX_BUCKETS || span > MAX_BUCKETS) return;
+
+    size_t grown{buckets};
+    while (grown < 2 * span && grown < MAX_BUCKETS) grown *= 2;
+    int64_t grownBase{lo - static_cast<int64_t>((grown - min(grown, span)) / 2)};
+
+    // Recover per-bucket values, then rebuild both trees in linear time.
+    vector<double> quantities(grown + 1, 0.0);
+    vector<double> notionals(grown + 1, 0.0);
+    for (size_t i = 0; i < buckets; ++i) {
+        size_t target{static_cast<size_t>(base + static_cast<int64_t>(i) - grownBase) + 1};
+        quantities[target] = prefixQuantity(i + 1) - prefixQuantity(i);
+        notionals[target] = prefixNotional(i + 1) - prefixNotional(i);
+    }
+    for (size_t i = 1; i <= grown; ++i) {
+        size_t parent{i + (i & (~i + 1))};
+        if (parent <= grown) {
+            quantities[parent] += quantities[i];
+            notionals[parent] += notionals[i];
+        }
+    }
+    quantityTree.swap(quantities);
+    notionalTree.swap(notionals);
+    buckets = grown;
+    base = grownBase;
+}
+
+void DepthIndex::update(size_t index, double quantityDelta, double notionalDelta) {
+    for (size_t i = index + 1; i <= buckets; i += i & (~i + 1)) {
+        quantityTree[i] += quantityDelta;
+        notionalTree[i] += notionalDelta;
+    }
+}
+
+void DepthIndex::add(double price, double quantityDelta) {
+    int64_t bucket{bucketOf(price)};
+    ensureRange(bucket);
+    int64_t index{min(max(bucket - base, int64_t{0}), static_cast<int64_t>(buckets) - 1)};
+    update(static_cast<size_t>(index), quantityDelta, price * quantityDelta);
+    quantity += quantityDelta;
+    notional += price * quantityDelta;
+}
+
+double DepthIndex::prefixQuantity(size_t count) const {
+    double sum{0.0};
+    for (size_t i = count; i > 0; i -= i & (~i + 1)) sum += quantityTree[i];
+    return sum;
+}
+
+double DepthIndex::prefixNotional(size_t count) const {
+    double sum{0.0};
+    for (size_t i = count; i > 0; i -= i & (~i + 1)) sum += notionalTree[i];
+    return sum;
+}
+
+size_t DepthIndex::leadingBuckets(double target, bool strict) const {
+    size_t step{1};
+    while (step * 2 <= buckets) step *= 2;
+
+    size_t position{0};
+    double sum{0.0};
+    for (; step > 0; step /= 2) {
+        size_t next{position + step};
+        if (next > buckets) continue;
+        double candidate{sum + quantityTree[next]};
+        if (strict ? candidate < target : candidate <= target) {
+            position = next;
+            sum = candidate;
+        }
+    }
+    return position;
+}
+
+size_t DepthIndex::clampedCount(double price, bool inclusive) const {
+    int64_t count{bucketOf(price) - base + (inclusive ? 1 : 0)};
+    return static_cast<size_t>(min(max(count, int64_t{0}), static_cast<int64_t>(buckets)));
+}
+
+double DepthIndex::quantityAtOrBelow(double price) const {
+    return prefixQuantity(clampedCount(price, true));
+}
+
+double DepthIndex::quantityAtOrAbove(double price) const {
+    return prefixQuantity(buckets) - prefixQuantity(clampedCount(price, false));
+}
+
+double DepthIndex::notionalAtOrBelow(double price) const {
+    return prefixNotional(clampedCount(price, true));
+}
+
+double DepthIndex::notionalAtOrAbove(double price) const {
+    return prefixNotional(buckets) - prefixNotional(clampedCount(price, false));
+}
+
+double DepthIndex::fillFromLow(double target, double& fillNotional, double& worstPrice) const {
+    fillNotional = 0.0;
+    worstPrice = 0.0;
+    double available{prefixQuantity(buckets)};
+    double filled{min(target, available)};
+    if (filled <= 0) return 0.0;
+
+    // Buckets [0, k) are consumed entirely; bucket k supplies the remainder.
+    size_t k{min(leadingBuckets(filled, true), buckets - 1)};
+    double quantityBefore{prefixQuantity(k)};
+    double notionalBefore{prefixNotional(k)};
+    double bucketQuantity{prefixQuantity(k + 1) - quantityBefore};
+    double bucketNotional{prefixNotional(k + 1) - notionalBefore};
+    worstPrice = bucketQuantity > 0 ? bucketNotional / bucketQuantity : (base + static_cast<int64_t>(k)) * tick;
+    fillNotional = notionalBefore + (filled - quantityBefore) * worstPrice;
+    return filled;
+}
+
+double DepthIndex::fillFromHigh(double target, double& fillNotional, double& worstPrice) const {
+    fillNotional = 0.0;
+    worstPrice = 0.0;
+    double available{prefixQuantity(buckets)};
+    double filled{min(target, available)};
+    if (filled <= 0) return 0.0;
+
+    // Buckets above k are consumed entirely; bucket k supplies the remainder.
+    size_t k{min(leadingBuckets(available - filled, false), buckets - 1)};
+    double quantityAbove{available - prefixQuantity(k + 1)};
+    double notionalAbove{prefixNotional(buckets) - prefixNotional(k + 1)};
+    double bucketQuantity{prefixQuantity(k + 1) - prefixQuantity(k)};
+    double bucketNotional{prefixNotional(k + 1) - prefixNotional(k)};
+    worstPrice = bucketQuantity > 0 ? bucketNotional / bucketQuantity : (base + static_cast<int64_t>(k)) * tick;
+    fillNotional = notionalAbove + (filled - quantityAbove) * worstPrice;
+    return filled;
+}
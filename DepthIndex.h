@@ -0,0 +1,71 @@
+#ifndef DEPTH_INDEX_H
+#define DEPTH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The scalar part of a DepthIndex, for checkpoints. Both trees hold buckets + 1 values once
+// the first price arrived and none before.
+struct DepthState {
+    double tick;
+    int64_t base;
+    uint64_t buckets;
+    double quantity;
+    double notional;
+};
+
+// Cumulative resting quantity and notional for one side of a book, as two Fenwick trees
+// over price buckets of tickSize. Buckets are indexed from low to high price; the window
+// of buckets is re-centred and doubled when a price falls outside it.
+// Updates and every query below are O(log buckets).
+class DepthIndex {
+public:
+    explicit DepthIndex(double tickSize = 0.01);
+
+    void add(double price, double quantity);
+    void clear();
+
+    double totalQuantity() const { return quantity; }
+    double totalNotional() const { return notional; }
+
+    // Resting quantity/notional at prices <= price, or >= price.
+    double quantityAtOrBelow(double price) const;
+    double quantityAtOrAbove(double price) const;
+    double notionalAtOrBelow(double price) const;
+    double notionalAtOrAbove(double price) const;
+
+    // Walks Q units from the low end (a buy against asks) or from the high end (a sell
+    // against bids). Returns the quantity actually available; notional and worst bucket
+    // price of that fill go to the out parameters.
+    double fillFromLow(double target, double& fillNotional, double& worstPrice) const;
+    double fillFromHigh(double target, double& fillNotional, double& worstPrice) const;
+
+    // The trees are saved as they are rather than summed again from the book, so a restored
+    // index goes on bit for bit. restore expects trees of the sizes DepthState describes.
+    DepthState getState() const { return DepthState{tick, base, buckets, quantity, notional}; }
+    const std::vector<double>& getQuantityTree() const { return quantityTree; }
+    const std::vector<double>& getNotionalTree() const { return notionalTree; }
+    void restore(const DepthState& state, const std::vector<double>& quantities, const std::vector<double>& notionals);
+
+private:
+    double tick;
+    int64_t base{0};
+    size_t buckets{0};
+    std::vector<double> quantityTree;
+    std::vector<double> notionalTree;
+    double quantity{0.0};
+    double notional{0.0};
+
+    int64_t bucketOf(double price) const;
+    void ensureRange(int64_t bucket);
+    void update(size_t index, double quantityDelta, double notionalDelta);
+    // Sums over buckets [0, count).
+    double prefixQuantity(size_t count) const;
+    double prefixNotional(size_t count) const;
+    // Number of leading buckets whose cumulative quantity stays <= target (or < target if strict).
+    size_t leadingBuckets(double target, bool strict) const;
+    size_t clampedCount(double price, bool inclusive) const;
+};
+
+#endif
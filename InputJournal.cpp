@@ -0,0 +1,277 @@
+#include "InputJournal.h"
+#include "OrderBookManager.h"
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+namespace {
+const char INPUT_JOURNAL_MAGIC[8]{'L', 'O', 'B', 'I', 'N', 'P', 'T', '1'};
+const uint64_t FNV_OFFSET{14695981039346656037ull};
+const uint64_t FNV_PRIME{1099511628211ull};
+
+void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const auto* bytes{static_cast<const unsigned char*>(data)};
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+}
+
+template <typename T>
+void hashValue(uint64_t& hash, const T& value) {
+    hashBytes(hash, &value, sizeof(value));
+}
+
+template <typename Book>
+void hashBook(uint64_t& hash, const Book& book) {
+    hashValue(hash, static_cast<uint64_t>(book.size()));
+    for (const auto& [price, entry] : book) {
+        hashValue(hash, price);
+        hashValue(hash, entry.quantity);
+        hashValue(hash, entry.id);
+        hashValue(hash, static_cast<int64_t>(
+            chrono::duration_cast<chrono::nanoseconds>(entry.timestamp.time_since_epoch()).count()));
+    }
+}
+
+int64_t steadyNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+uint64_t bookDigest(const OrderBookManager& manager) {
+    uint64_t hash{FNV_OFFSET};
+    for (const auto& [asset, book] : manager.getBidBooks()) {
+        if (book.empty()) continue;
+        hashBytes(hash, asset.data(), asset.size());
+        hashBook(hash, book);
+    }
+    for (const auto& [asset, book] : manager.getAskBooks()) {
+        if (book.empty()) continue;
+        hashBytes(hash, asset.data(), asset.size());
+        hashBook(hash, book);
+    }
+    const OrderBookStatistics empty{};
+    for (const auto& [asset, stats] : manager.getStatistics()) {
+        if (memcmp(&stats, &empty, sizeof(stats)) == 0) continue;
+        hashBytes(hash, asset.data(), asset.size());
+        hashValue(hash, stats);
+    }
+    return hash;
+}
+
+InputJournal::InputJournal(const string& journalPath) : path(journalPath) {
+    if (!appender.open(path, INPUT_JOURNAL_MAGIC, INPUT_JOURNAL_VERSION, sizeof(InputRecord), sizeof(InputJournalHeader))) {
+        cerr << "Error: unable to open input journal " << path << "\n";
+        return;
+    }
+    const JournalSymbolTable& table{header()->symbols};
+    for (uint32_t i = 0; i < table.count && i < JOURNAL_MAX_SYMBOLS; ++i) {
+        symbolIds[string(table.symbols[i], strnlen(table.symbols[i], JOURNAL_SYMBOL_LENGTH))] = static_cast<int32_t>(i);
+    }
+}
+
+InputJournalHeader* InputJournal::header() {
+    return reinterpret_cast<InputJournalHeader*>(appender.userHeader());
+}
+
+int32_t InputJournal::intern(const string& symbol) {
+    auto it{symbolIds.find(symbol)};
+    if (it != symbolIds.end()) return it->second;
+
+    JournalSymbolTable& table{header()->symbols};
+    if (table.count >= JOURNAL_MAX_SYMBOLS || symbol.size() >= JOURNAL_SYMBOL_LENGTH) {
+        cerr << "Error: input journal " << path << " has no room for symbol " << symbol << " (at most "
+             << JOURNAL_MAX_SYMBOLS << " symbols under " << JOURNAL_SYMBOL_LENGTH << " characters); record not written\n";
+        return -1;
+    }
+
+    int32_t id{static_cast<int32_t>(table.count)};
+    memcpy(table.symbols[id], symbol.data(), symbol.size());
+    table.count++;
+    symbolIds[symbol] = id;
+    return id;
+}
+
+void InputJournal::append(InputRecordKind kind, const string* asset, bool isBuy, int orderId, double price,
+                          double quantity, int64_t timestamp, bool isShortSell, TimeInForce timeInForce,
+                          int64_t expireTime, OrderType orderType, double stopPrice, UncrossMode uncrossMode) {
+    if (!isOpen()) return;
+    InputRecord record{};
+    record.kind = kind;
+    record.arrivalNanos = steadyNanos();
+    record.timestamp = timestamp;
+    record.price = price;
+    record.quantity = quantity;
+    record.orderId = orderId;
+    record.side = isBuy ? 0 : 1;
+    record.isShortSell = isShortSell ? 1 : 0;
+    record.timeInForce = timeInForce;
+    record.expireTime = expireTime;
+    record.orderType = orderType;
+    record.stopPrice = stopPrice;
+    record.uncrossMode = uncrossMode;
+
+    lock_guard<mutex> lock(appendMutex);
+    record.symbolId = asset ? intern(*asset) : -1;
+    if (asset && record.symbolId < 0) return;
+    record.sequence = appender.size();
+    appender.append(&record);
+}
+
+void InputJournal::append(InputRecordKind kind, const Order& order) {
+    append(kind, &order.asset, order.type == "BUY", order.id, order.price, order.quantity,
+           chrono::duration_cast<chrono::nanoseconds>(order.dateTime.time_since_epoch()).count(), order.isShortSell,
+           order.timeInForce, chrono::duration_cast<chrono::nanoseconds>(order.expireTime.time_since_epoch()).count(),
+           order.orderType, order.stopPrice);
+}
+
+void InputJournal::recordNewOrder(const Order& order) {
+    append(InputRecordKind::New, order);
+}
+
+void InputJournal::recordNewOrder(const string& asset, bool isBuy, int orderId, double price, double quantity,
+                                  int64_t timestamp, bool isShortSell, TimeInForce timeInForce, int64_t expireTime,
+                                  OrderType orderType, double stopPrice) {
+    append(InputRecordKind::New, &asset, isBuy, orderId, price, quantity, timestamp, isShortSell, timeInForce, expireTime,
+           orderType, stopPrice);
+}
+
+void InputJournal::recordLoadedOrder(const Order& order) {
+    append(InputRecordKind::Loaded, order);
+}
+
+void InputJournal::recordUncross(UncrossMode mode) {
+    append(InputRecordKind::Uncross, nullptr, false, 0, 0.0, 0.0, 0, false, TimeInForce::GTC, 0, OrderType::Limit, 0.0,
+           mode);
+}
+
+void InputJournal::recordAuction(const string& asset) {
+    append(InputRecordKind::Auction, &asset, false, 0, 0.0, 0.0, 0, false, TimeInForce::GTC, 0, OrderType::Limit, 0.0);
+}
+
+void InputJournal::recordClock(int64_t timestamp) {
+    append(InputRecordKind::Clock, nullptr, false, 0, 0.0, 0.0, timestamp, false, TimeInForce::GTC, 0, OrderType::Limit, 0.0);
+}
+
+void InputJournal::recordCancel(int orderId) {
+    append(InputRecordKind::Cancel, nullptr, false, orderId, 0.0, 0.0, 0, false, TimeInForce::GTC, 0, OrderType::Limit, 0.0);
+}
+
+void InputJournal::seal(const OrderBookManager& manager) {
+    if (!isOpen()) return;
+    lock_guard<mutex> lock(appendMutex);
+    header()->sealedRecords = appender.size();
+    header()->sealedDigest = bookDigest(manager);
+    appender.flush();
+}
+
+void InputJournal::flush() {
+    lock_guard<mutex> lock(appendMutex);
+    appender.flush();
+}
+
+InputJournalReader::InputJournalReader(const string& path) {
+    reader.open(path, INPUT_JOURNAL_MAGIC, INPUT_JOURNAL_VERSION, sizeof(InputRecord));
+    const InputJournalHeader* h{header()};
+    for (uint32_t i = 0; h && i < h->symbols.count; ++i) symbols.push_back(symbol(static_cast<int32_t>(i)));
+}
+
+const InputJournalHeader* InputJournalReader::header() const {
+    return reinterpret_cast<const InputJournalHeader*>(reader.userHeader());
+}
+
+InputRecord InputJournalReader::at(uint64_t index) const {
+    InputRecord record;
+    memcpy(&record, reader.record(index), sizeof(record));
+    return record;
+}
+
+string InputJournalReader::symbol(int32_t id) const {
+    const InputJournalHeader* h{header()};
+    if (!h || id < 0 || static_cast<uint32_t>(id) >= h->symbols.count) return "";
+    return string(h->symbols.symbols[id], strnlen(h->symbols.symbols[id], JOURNAL_SYMBOL_LENGTH));
+}
+
+uint64_t InputJournalReader::sealedRecords() const {
+    return header() ? header()->sealedRecords : 0;
+}
+
+uint64_t InputJournalReader::sealedDigest() const {
+    return header() ? header()->sealedDigest : 0;
+}
+
+ReplayResult InputJournalReader::replay(OrderBookManager& manager, ReplayPacing pacing, double speed) const {
+    ReplayResult result;
+    if (!isOpen()) return result;
+
+    uint64_t checkAt{sealedRecords()};
+    Order order{};
+    auto start{chrono::steady_clock::now()};
+    int64_t lastArrival{size() > 0 ? at(0).arrivalNanos : 0};
+    int64_t pacedNanos{0};
+
+    for (uint64_t i = 0; i < size(); ++i) {
+        if (pacing == ReplayPacing::Recorded && speed > 0) {
+            // Gaps across sessions (clock went backwards) are replayed as zero.
+            int64_t arrival{at(i).arrivalNanos};
+            int64_t gap{arrival - lastArrival};
+            if (gap > 0) pacedNanos += static_cast<int64_t>(gap / speed);
+            lastArrival = arrival;
+            this_thread::sleep_until(start + chrono::nanoseconds(pacedNanos));
+        }
+
+        InputRecordKind kind{apply(i, manager, order).kind};
+        if (kind == InputRecordKind::New || kind == InputRecordKind::Loaded) result.orders++;
+        result.records++;
+
+        if (result.records == checkAt) {
+            result.digest = bookDigest(manager);
+            result.verified = true;
+            result.matched = result.digest == sealedDigest();
+        }
+    }
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!result.verified) result.digest = bookDigest(manager);
+    return result;
+}
+
+InputRecord InputJournalReader::apply(uint64_t index, OrderBookManager& manager, Order& order) const {
+    InputRecord r{at(index)};
+    // The reused Order keeps short strings in place.
+    const string& asset{(r.symbolId >= 0 && static_cast<size_t>(r.symbolId) < symbols.size()) ? symbols[r.symbolId]
+                                                                                             : noSymbol};
+    if (r.kind == InputRecordKind::Uncross) {
+        manager.setUncrossMode(r.uncrossMode);
+        manager.processOrders();
+    } else if (r.kind == InputRecordKind::Auction) {
+        manager.runAuction(asset);
+    } else if (r.kind == InputRecordKind::Clock) {
+        manager.advanceClock(r.timestamp);
+    } else if (r.kind == InputRecordKind::Cancel) {
+        manager.cancelOrder(r.orderId);
+    } else {
+        order.id = r.orderId;
+        order.asset = asset;
+        order.type = r.side == 0 ? "BUY" : "SELL";
+        order.isShortSell = r.isShortSell != 0;
+        order.price = r.price;
+        order.quantity = r.quantity;
+        order.totalAmount = r.price * r.quantity;
+        order.dateTime = chrono::system_clock::time_point(
+            chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(r.timestamp)));
+        order.timeInForce = r.timeInForce;
+        order.orderType = r.orderType;
+        order.stopPrice = r.stopPrice;
+        order.expireTime = chrono::system_clock::time_point(
+            chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(r.expireTime)));
+        if (r.kind == InputRecordKind::New) {
+            manager.processNewOrder(order);
+        } else {
+            manager.queueOrder(order);
+        }
+    }
+    return r;
+}
@@ -0,0 +1,153 @@
+#ifndef INPUT_JOURNAL_H
+#define INPUT_JOURNAL_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Journal.h"
+#include "MappedFile.h"
+#include "OrderMessage.h"
+
+struct Order;
+class OrderBookManager;
+enum class UncrossMode : uint8_t;
+
+// New: one order through processNewOrder.
+// Loaded: one order inserted by processOrders; Uncross closes that batch and runs the uncross
+// in the record's uncrossMode. Clock: an explicit advanceClock to timestamp.
+// Cancel: cancelOrder(orderId). Auction: runAuction on the record's symbol.
+enum class InputRecordKind : uint8_t {
+    New = 0,
+    Loaded = 1,
+    Uncross = 2,
+    Clock = 3,
+    Cancel = 4,
+    Auction = 5
+};
+
+// arrivalNanos is a steady-clock reading taken when the order reached the engine and is only
+// used to reproduce pacing; timestamp is the order's own dateTime in nanoseconds, expireTime
+// its GTT expiry and stopPrice the trigger of a stop (both zero otherwise).
+struct InputRecord {
+    uint64_t sequence;
+    int64_t timestamp;
+    int64_t arrivalNanos;
+    int64_t expireTime;
+    double price;
+    double quantity;
+    double stopPrice;
+    int32_t orderId;
+    int32_t symbolId;
+    uint8_t side;
+    InputRecordKind kind;
+    uint8_t isShortSell;
+    TimeInForce timeInForce;
+    OrderType orderType;
+    UncrossMode uncrossMode;
+    uint8_t reserved[2];
+};
+
+static_assert(sizeof(InputRecord) == 72, "InputRecord layout is part of the file format");
+static_assert(std::is_trivially_copyable<InputRecord>::value, "InputRecord must be memcpy-able");
+
+const uint32_t INPUT_JOURNAL_VERSION{4};
+
+// sealedRecords/sealedDigest hold the book digest observed after the first sealedRecords
+// records, so a replay of the same prefix can prove it reached the same state.
+struct InputJournalHeader {
+    JournalSymbolTable symbols;
+    uint64_t sealedRecords;
+    uint64_t sealedDigest;
+};
+
+// FNV-1a over every level (price, quantity, id, timestamp) and every statistics block.
+uint64_t bookDigest(const OrderBookManager& manager);
+
+// Sequenced record of every order entering an OrderBookManager, in arrival order.
+// Appends are serialized so the simulator thread and the console can share one journal.
+class InputJournal {
+public:
+    explicit InputJournal(const std::string& path);
+
+    bool isOpen() const { return appender.isOpen(); }
+    const std::string& getPath() const { return path; }
+    uint64_t size() const { return appender.size(); }
+
+    void recordNewOrder(const Order& order);
+    void recordNewOrder(const std::string& asset, bool isBuy, int orderId, double price, double quantity,
+                        int64_t timestamp, bool isShortSell, TimeInForce timeInForce = TimeInForce::GTC,
+                        int64_t expireTime = 0, OrderType orderType = OrderType::Limit, double stopPrice = 0.0);
+    void recordLoadedOrder(const Order& order);
+    void recordUncross(UncrossMode mode);
+    void recordAuction(const std::string& asset);
+    void recordClock(int64_t timestamp);
+    void recordCancel(int orderId);
+
+    // Stores the digest of manager's current state against the current record count.
+    void seal(const OrderBookManager& manager);
+    void flush();
+
+private:
+    std::string path;
+    MappedAppender appender;
+    std::map<std::string, int32_t> symbolIds;
+    std::mutex appendMutex;
+
+    InputJournalHeader* header();
+    int32_t intern(const std::string& symbol);
+    // A record whose symbol does not fit the symbol table is not written.
+    void append(InputRecordKind kind, const std::string* asset, bool isBuy, int orderId, double price,
+                double quantity, int64_t timestamp, bool isShortSell, TimeInForce timeInForce, int64_t expireTime,
+                OrderType orderType, double stopPrice, UncrossMode uncrossMode = UncrossMode{});
+    void append(InputRecordKind kind, const Order& order);
+};
+
+enum class ReplayPacing {
+    MaxSpeed,
+    Recorded
+};
+
+struct ReplayResult {
+    uint64_t records{0};
+    uint64_t orders{0};
+    double seconds{0.0};
+    uint64_t digest{0};
+    bool verified{false};
+    bool matched{false};
+};
+
+class InputJournalReader {
+public:
+    explicit InputJournalReader(const std::string& path);
+
+    bool isOpen() const { return reader.isOpen(); }
+    uint64_t size() const { return reader.size(); }
+    InputRecord at(uint64_t index) const;
+    std::string symbol(int32_t id) const;
+    uint64_t sealedRecords() const;
+    uint64_t sealedDigest() const;
+
+    // Feeds every record into manager (normally a fresh one) in sequence order. Recorded pacing
+    // sleeps to reproduce the original inter-arrival gaps divided by speed. The result is
+    // verified when the journal was sealed at its full length.
+    ReplayResult replay(OrderBookManager& manager, ReplayPacing pacing = ReplayPacing::MaxSpeed,
+                        double speed = 1.0) const;
+    // Feeds record index into manager as replay does and returns it; order is scratch reused
+    // across calls. The reader is not modified, so threads can each drive their own manager
+    // from one mapping.
+    InputRecord apply(uint64_t index, OrderBookManager& manager, Order& order) const;
+
+private:
+    MappedReader reader;
+    // Resolved once at open; an unknown id maps to noSymbol.
+    std::vector<std::string> symbols;
+    const std::string noSymbol;
+
+    const InputJournalHeader* header() const;
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include "Journal.h"
+#include "BankAccount.h"
+#include "Portfolio.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+const char JOURNAL_MAGIC[8]{'L', 'O', 'B', 'J', 'R', 'N', 'L', '1'};
+const int64_t NANOS_PER_SECOND{1000000000};
+
+int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era{(y >= 0 ? y : y - 399) / 400};
+    const unsigned yoe{static_cast<unsigned>(y - era * 400)};
+    const unsigned doy{(153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1};
+    const unsigned doe{yoe * 365 + yoe / 4 - yoe / 100 + doy};
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civilFromDays(int64_t z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era{(z >= 0 ? z : z - 146096) / 146097};
+    const unsigned doe{static_cast<unsigned>(z - era * 146097)};
+    const unsigned yoe{(doe - doe / 1460 + doe / 36524 - doe / 146096) / 365};
+    const unsigned doy{doe - (365 * yoe + yoe / 4 - yoe / 100)};
+    const unsigned mp{(5 * doy + 2) / 153};
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(static_cast<int64_t>(yoe) + era * 400 + (m <= 2));
+}
+
+int readNumber(const string& s, size_t pos, size_t len) {
+    int value{0};
+    for (size_t i = pos; i < pos + len && i < s.size(); ++i) {
+        if (s[i] < '0' || s[i] > '9') return -1;
+        value = value * 10 + (s[i] - '0');
+    }
+    return value;
+}
+}
+
+// Timestamps are stored as the wall-clock fields of "YYYY-MM-DD HH:MM:SS" encoded
+// as if UTC, so they round-trip exactly without a time-zone lookup on the hot path.
+int64_t toEpochNanos(const string& dateTime) {
+    if (dateTime.size() < 19) return 0;
+    int year{readNumber(dateTime, 0, 4)};
+    int month{readNumber(dateTime, 5, 2)};
+    int day{readNumber(dateTime, 8, 2)};
+    int hour{readNumber(dateTime, 11, 2)};
+    int minute{readNumber(dateTime, 14, 2)};
+    int second{readNumber(dateTime, 17, 2)};
+    if (year < 0 || month < 1 || day < 1 || hour < 0 || minute < 0 || second < 0) return 0;
+
+    int64_t days{daysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day))};
+    return ((days * 24 + hour) * 60 + minute) * 60 * NANOS_PER_SECOND + second * NANOS_PER_SECOND;
+}
+
+string formatEpochNanos(int64_t timestamp) {
+    int64_t seconds{timestamp / NANOS_PER_SECOND};
+    int64_t days{seconds / 86400};
+    int64_t rem{seconds % 86400};
+    if (rem < 0) {
+        rem += 86400;
+        --days;
+    }
+    int year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u %02d:%02d:%02d", year, month, day,
+             static_cast<int>(rem / 3600), static_cast<int>((rem % 3600) / 60), static_cast<int>(rem % 60));
+    return string(buffer);
+}
+
+Journal::Journal(const string& journalPath) : path(journalPath) {
+    if (!appender.open(path, JOURNAL_MAGIC, JOURNAL_VERSION, sizeof(JournalRecord), sizeof(JournalSymbolTable))) {
+        cerr << "Error: unable to open journal " << path << "\n";
+        return;
+    }
+    const auto* table{reinterpret_cast<const JournalSymbolTable*>(appender.userHeader())};
+    for (uint32_t i = 0; i < table->count && i < JOURNAL_MAX_SYMBOLS; ++i) {
+        symbolIds[string(table->symbols[i], strnlen(table->symbols[i], JOURNAL_SYMBOL_LENGTH))] = static_cast<int32_t>(i);
+    }
+}
+
+int32_t Journal::intern(const string& symbol) {
+    auto it{symbolIds.find(symbol)};
+    if (it != symbolIds.end()) return it->second;
+
+    auto* table{reinterpret_cast<JournalSymbolTable*>(appender.userHeader())};
+    if (table->count >= JOURNAL_MAX_SYMBOLS || symbol.size() >= JOURNAL_SYMBOL_LENGTH) {
+        cerr << "Error: journal " << path << " has no room for symbol " << symbol << " (at most " << JOURNAL_MAX_SYMBOLS
+             << " symbols under " << JOURNAL_SYMBOL_LENGTH << " characters); record not written\n";
+        return -1;
+    }
+
+    int32_t id{static_cast<int32_t>(table->count)};
+    memcpy(table->symbols[id], symbol.data(), symbol.size());
+    table->count++;
+    symbolIds[symbol] = id;
+    return id;
+}
+
+void Journal::recordTrade(const string& stock, const string& tradeType,
+                          double quantity, double price, const string& dateTime) {
+    if (!isOpen()) return;
+    int32_t symbolId{intern(stock)};
+    if (symbolId < 0) return;
+    JournalRecord record{toEpochNanos(dateTime), JournalRecordType::Trade, symbolId,
+                         tradeType == "BUY" ? 0u : 1u, 0, quantity, price, quantity * price, 0.0};
+    appender.append(&record);
+}
+
+void Journal::recordPnL(const string& stock, double realizedPnL, double quantity, const string& dateTime) {
+    if (!isOpen()) return;
+    int32_t symbolId{intern(stock)};
+    if (symbolId < 0) return;
+    JournalRecord record{toEpochNanos(dateTime), JournalRecordType::RealizedPnL, symbolId,
+                         0, 0, quantity, 0.0, realizedPnL, 0.0};
+    appender.append(&record);
+}
+
+void Journal::recordTransaction(const string& type, double amount, double balance, const string& dateTime) {
+    if (!isOpen()) return;
+    JournalRecord record{toEpochNanos(dateTime), JournalRecordType::Transaction, -1,
+                         type == "Deposit" ? 0u : 1u, 0, 0.0, 0.0, amount, balance};
+    appender.append(&record);
+}
+
+void Journal::flush() {
+    appender.flush();
+}
+
+JournalReader::JournalReader(const string& path) {
+    reader.open(path, JOURNAL_MAGIC, JOURNAL_VERSION, sizeof(JournalRecord));
+}
+
+JournalRecord JournalReader::at(uint64_t index) const {
+    JournalRecord record;
+    memcpy(&record, reader.record(index), sizeof(record));
+    return record;
+}
+
+string JournalReader::symbol(int32_t id) const {
+    const auto* table{reinterpret_cast<const JournalSymbolTable*>(reader.userHeader())};
+    if (!table || id < 0 || static_cast<uint32_t>(id) >= table->count) return "";
+    return string(table->symbols[id], strnlen(table->symbols[id], JOURNAL_SYMBOL_LENGTH));
+}
+
+bool JournalReader::exportTradesCSV(const string& filename) const {
+    ofstream file(filename);
+    if (!file.is_open()) {
+        cerr << "Error: file access denied" << endl;
+        return false;
+    }
+    file << "DateTime,Stock,TradeType,Quantity,Price,TotalAmount\n";
+    for (uint64_t i = 0; i < size(); ++i) {
+        JournalRecord r{at(i)};
+        if (r.type != JournalRecordType::Trade) continue;
+        file << formatEpochNanos(r.timestamp) << "," << symbol(r.symbolId) << ","
+             << (r.side == 0 ? "BUY" : "SELL") << "," << r.quantity << "," << r.price << "," << r.amount << "\n";
+    }
+    return true;
+}
+
+bool JournalReader::exportPnLCSV(const string& filename) const {
+    ofstream file(filename);
+    if (!file.is_open()) {
+        cerr << "Error opening portfolio PnL CSV file." << endl;
+        return false;
+    }
+    file << "DateTime,Stock,Quantity,RealizedPnL\n";
+    for (uint64_t i = 0; i < size(); ++i) {
+        JournalRecord r{at(i)};
+        if (r.type != JournalRecordType::RealizedPnL) continue;
+        file << formatEpochNanos(r.timestamp) << "," << symbol(r.symbolId) << ","
+             << r.quantity << "," << r.amount << "\n";
+    }
+    return true;
+}
+
+bool JournalReader::exportTransactionsCSV(const string& filename) const {
+    ofstream file(filename);
+    if (!file.is_open()) {
+        cerr << "Error opening bank account CSV file." << endl;
+        return false;
+    }
+    file << "DateTime,Type,Amount,ResultingBalance\n";
+    for (uint64_t i = 0; i < size(); ++i) {
+        JournalRecord r{at(i)};
+        if (r.type != JournalRecordType::Transaction) continue;
+        file << formatEpochNanos(r.timestamp) << "," << (r.side == 0 ? "Deposit" : "Withdrawal") << ","
+             << r.amount << "," << r.balance << "\n";
+    }
+    return true;
+}
+
+void JournalReader::rebuild(Portfolio& portfolio, BankAccount& account, uint64_t fromRecord) const {
+    for (uint64_t i = fromRecord; i < size(); ++i) {
+        JournalRecord r{at(i)};
+        string dateTime{formatEpochNanos(r.timestamp)};
+        if (r.type == JournalRecordType::Trade) {
+            if (r.side == 0) {
+                portfolio.updateBuy(symbol(r.symbolId), r.quantity, r.price, dateTime);
+            } else {
+                portfolio.updateSell(symbol(r.symbolId), r.quantity, r.price, dateTime);
+            }
+        } else if (r.type == JournalRecordType::Transaction) {
+            if (r.side == 0) {
+                account.deposit(r.amount, dateTime);
+            } else {
+                account.withdraw(r.amount, dateTime);
+            }
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <type_traits>
+
+#include "MappedFile.h"
+
+class Portfolio;
+class BankAccount;
+
+enum class JournalRecordType : uint32_t {
+    Trade = 1,
+    RealizedPnL = 2,
+    Transaction = 3
+};
+
+// side: Trade -> 0 BUY / 1 SELL, Transaction -> 0 Deposit / 1 Withdrawal.
+// symbolId indexes the symbol table stored in the journal header (-1 for cash records).
+struct JournalRecord {
+    int64_t timestamp;
+    JournalRecordType type;
+    int32_t symbolId;
+    uint32_t side;
+    uint32_t reserved;
+    double quantity;
+    double price;
+    double amount;
+    double balance;
+};
+
+static_assert(sizeof(JournalRecord) == 56, "JournalRecord layout is part of the file format");
+static_assert(std::is_trivially_copyable<JournalRecord>::value, "JournalRecord must be memcpy-able");
+
+const uint32_t JOURNAL_VERSION{1};
+const uint32_t JOURNAL_MAX_SYMBOLS{64};
+const uint32_t JOURNAL_SYMBOL_LENGTH{16};
+
+struct JournalSymbolTable {
+    uint32_t count;
+    uint32_t reserved;
+    char symbols[JOURNAL_MAX_SYMBOLS][JOURNAL_SYMBOL_LENGTH];
+};
+
+int64_t toEpochNanos(const std::string& dateTime);
+std::string formatEpochNanos(int64_t timestamp);
+
+class Journal {
+public:
+    explicit Journal(const std::string& path);
+
+    bool isOpen() const { return appender.isOpen(); }
+    const std::string& getPath() const { return path; }
+    uint64_t size() const { return appender.size(); }
+
+    void recordTrade(const std::string& stock, const std::string& tradeType,
+                     double quantity, double price, const std::string& dateTime);
+    void recordPnL(const std::string& stock, double realizedPnL, double quantity,
+                   const std::string& dateTime);
+    void recordTransaction(const std::string& type, double amount, double balance,
+                           const std::string& dateTime);
+    void flush();
+
+private:
+    std::string path;
+    MappedAppender appender;
+    std::map<std::string, int32_t> symbolIds;
+
+    // -1, with a diagnostic, when the symbol does not fit the table; the record is then not
+    // written.
+    int32_t intern(const std::string& symbol);
+};
+
+class JournalReader {
+public:
+    explicit JournalReader(const std::string& path);
+
+    bool isOpen() const { return reader.isOpen(); }
+    uint64_t size() const { return reader.size(); }
+    JournalRecord at(uint64_t index) const;
+    std::string symbol(int32_t id) const;
+
+    bool exportTradesCSV(const std::string& filename) const;
+    bool exportPnLCSV(const std::string& filename) const;
+    bool exportTransactionsCSV(const std::string& filename) const;
+
+    // Replays trades and cash movements from fromRecord on (e.g. the offset stored in a
+    // checkpoint); call before attaching a journal to the targets.
+    void rebuild(Portfolio& portfolio, BankAccount& account, uint64_t fromRecord = 0) const;
+
+private:
+    MappedReader reader;
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "Ledger.h"
+
+using namespace std;
+
+Ledger::Ledger(size_t assetCount) : assets(assetCount) {}
+
+uint32_t Ledger::addAccount(double initialCash) {
+    uint32_t accountId{static_cast<uint32_t>(cashBalances.size())};
+    cashBalances.push_back(initialCash);
+    positions.resize(positions.size() + assets, 0.0);
+    averagePrices.resize(averagePrices.size() + assets, 0.0);
+    realizedPnLs.resize(realizedPnLs.size() + assets, 0.0);
+    return accountId;
+}
+
+void Ledger::reserve(size_t accounts) {
+    cashBalances.reserve(accounts);
+    positions.reserve(accounts * assets);
+    averagePrices.reserve(accounts * assets);
+    realizedPnLs.reserve(accounts * assets);
+}
+
+double Ledger::totalRealizedPnL(uint32_t accountId) const {
+    double total{0.0};
+    size_t base{slot(accountId, 0)};
+    for (size_t i = 0; i < assets; ++i) {
+        total += realizedPnLs[base + i];
+    }
+    return total;
+}
+
+void Ledger::restorePosition(uint32_t accountId, uint32_t assetId, double quantity, double averagePrice, double realized) {
+    size_t i{slot(accountId, assetId)};
+    positions[i] = quantity;
+    averagePrices[i] = averagePrice;
+    realizedPnLs[i] = realized;
+}
+
+bool Ledger::credit(uint32_t accountId, double amount) {
+    if (amount <= 0) return false;
+    cashBalances[accountId] += amount;
+    return true;
+}
+
+bool Ledger::debit(uint32_t accountId, double amount) {
+    if (amount <= 0 || amount > cashBalances[accountId]) return false;
+    cashBalances[accountId] -= amount;
+    return true;
+}
+
+void Ledger::addPosition(uint32_t accountId, uint32_t assetId, double quantity, double price) {
+    size_t i{slot(accountId, assetId)};
+    double totalCost{positions[i] * averagePrices[i] + quantity * price};
+    positions[i] += quantity;
+    averagePrices[i] = (positions[i] > 0) ? totalCost / positions[i] : price;
+}
+
+bool Ledger::reducePosition(uint32_t accountId, uint32_t assetId, double quantity, double price, double& realized) {
+    size_t i{slot(accountId, assetId)};
+    if (positions[i] < quantity) return false;
+    realized = (price - averagePrices[i]) * quantity;
+    realizedPnLs[i] += realized;
+    positions[i] -= quantity;
+    if (positions[i] <= 0) {
+        positions[i] = 0.0;
+        averagePrices[i] = 0.0;
+    }
+    return true;
+}
+
+bool Ledger::applyFill(const LedgerFill& fill) {
+    size_t i{slot(fill.accountId, fill.assetId)};
+    double& cash{cashBalances[fill.accountId]};
+
+    if (fill.quantity > 0) {
+        double cost{fill.quantity * fill.price};
+        if (cost > cash) return false;
+        cash -= cost;
+        double totalCost{positions[i] * averagePrices[i] + cost};
+        positions[i] += fill.quantity;
+        averagePrices[i] = totalCost / positions[i];
+    } else {
+        double quantity{-fill.quantity};
+        if (quantity > positions[i]) return false;
+        cash += quantity * fill.price;
+        realizedPnLs[i] += (fill.price - averagePrices[i]) * quantity;
+        positions[i] -= quantity;
+        if (positions[i] <= 0) {
+            positions[i] = 0.0;
+            averagePrices[i] = 0.0;
+        }
+    }
+    return true;
+}
+
+size_t Ledger::applyFills(const LedgerFill* fills, size_t count, uint8_t* rejected) {
+    size_t applied{0};
+    for (size_t k = 0; k < count; ++k) {
+        const LedgerFill& fill{fills[k]};
+        bool ok{isValid(fill.accountId, fill.assetId) && fill.quantity != 0 && applyFill(fill)};
+        applied += ok;
+        if (rejected) rejected[k] = !ok;
+    }
+    return applied;
+}
+
+size_t Ledger::applyFills(const vector<LedgerFill>& fills, vector<uint8_t>* rejected) {
+    if (rejected) rejected->assign(fills.size(), 0);
+    return applyFills(fills.data(), fills.size(), rejected ? rejected->data() : nullptr);
+}
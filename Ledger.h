@@ -0,0 +1,69 @@
+#ifndef LEDGER_H
+#define LEDGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A fill to settle against one account: positive quantity buys, negative sells.
+struct LedgerFill {
+    uint32_t accountId;
+    uint32_t assetId;
+    double quantity;
+    double price;
+};
+
+// Cash and positions for N accounts x M assets in structure-of-arrays form.
+// Per-asset arrays are laid out account-major (index = accountId * assetCount + assetId)
+// so one account's positions share a cache line and a batch touches each array linearly.
+class Ledger {
+public:
+    explicit Ledger(size_t assetCount);
+
+    uint32_t addAccount(double initialCash);
+    void reserve(size_t accounts);
+
+    size_t accountCount() const { return cashBalances.size(); }
+    size_t assetCount() const { return assets; }
+    bool isValid(uint32_t accountId, uint32_t assetId) const {
+        return accountId < cashBalances.size() && assetId < assets;
+    }
+
+    double cash(uint32_t accountId) const { return cashBalances[accountId]; }
+    double position(uint32_t accountId, uint32_t assetId) const { return positions[slot(accountId, assetId)]; }
+    double averagePrice(uint32_t accountId, uint32_t assetId) const { return averagePrices[slot(accountId, assetId)]; }
+    double realizedPnL(uint32_t accountId, uint32_t assetId) const { return realizedPnLs[slot(accountId, assetId)]; }
+    double totalRealizedPnL(uint32_t accountId) const;
+
+    void setCash(uint32_t accountId, double amount) { cashBalances[accountId] = amount; }
+    void restorePosition(uint32_t accountId, uint32_t assetId, double quantity, double averagePrice, double realized);
+
+    bool credit(uint32_t accountId, double amount);
+    bool debit(uint32_t accountId, double amount);
+
+    // Position-only updates used when cash is settled separately (BankAccount view).
+    void addPosition(uint32_t accountId, uint32_t assetId, double quantity, double price);
+    bool reducePosition(uint32_t accountId, uint32_t assetId, double quantity, double price, double& realized);
+
+    // Settles cash and position together. Buys need enough cash and sells enough
+    // position; failing fills are skipped and flagged in rejected (if given).
+    bool applyFill(const LedgerFill& fill);
+    size_t applyFills(const LedgerFill* fills, size_t count, uint8_t* rejected = nullptr);
+    size_t applyFills(const std::vector<LedgerFill>& fills, std::vector<uint8_t>* rejected = nullptr);
+
+    const std::vector<double>& getCashBalances() const { return cashBalances; }
+    const std::vector<double>& getPositions() const { return positions; }
+    const std::vector<double>& getAveragePrices() const { return averagePrices; }
+    const std::vector<double>& getRealizedPnLs() const { return realizedPnLs; }
+
+private:
+    size_t assets;
+    std::vector<double> cashBalances;
+    std::vector<double> positions;
+    std::vector<double> averagePrices;
+    std::vector<double> realizedPnLs;
+
+    size_t slot(uint32_t accountId, uint32_t assetId) const { return static_cast<size_t>(accountId) * assets + assetId; }
+};
+
+#endif
@@ -0,0 +1,524 @@
+#include "MappedFile.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+using namespace std;
+
+namespace {
+const size_t GROWTH_CHUNK{1 << 20};
+
+// A file written in another version of its format is refused rather than read or extended.
+bool headerMatches(const MappedFileHeader& header, const char* magic, uint32_t version, uint32_t recordSize) {
+    return memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.version == version &&
+           header.recordSize == recordSize;
+}
+
+MappedFileHeader makeHeader(const char* magic, uint32_t version, uint32_t recordSize, uint32_t userHeaderSize) {
+    MappedFileHeader header{};
+    memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = version;
+    header.recordSize = recordSize;
+    header.userHeaderSize = userHeaderSize;
+    return header;
+}
+}
+
+#ifndef _WIN32
+
+MappedAppender::MappedAppender()
+    : opened(false), created(false), recordSize(0), userHeaderSize(0), recordCount(0),
+      fd(-1), base(nullptr), capacity(0) {}
+
+MappedAppender::~MappedAppender() {
+    close();
+}
+
+bool MappedAppender::open(const string& path, const char* magic, uint32_t version,
+                          uint32_t recSize, uint32_t userHdrSize) {
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+
+    recordSize = recSize;
+    userHeaderSize = userHdrSize;
+    size_t fileSize{static_cast<size_t>(st.st_size)};
+
+    if (fileSize == 0) {
+        created = true;
+        recordCount = 0;
+    } else {
+        MappedFileHeader existing{};
+        if (fileSize < sizeof(existing) || pread(fd, &existing, sizeof(existing), 0) != sizeof(existing) ||
+            !headerMatches(existing, magic, version, recordSize) || existing.userHeaderSize != userHeaderSize) {
+            close();
+            return false;
+        }
+        created = false;
+        uint64_t onDisk{(fileSize - dataOffset()) / recordSize};
+        recordCount = min(existing.recordCount, onDisk);
+    }
+
+    size_t needed{dataOffset() + recordCount * recordSize};
+    if (!remap(max(needed + GROWTH_CHUNK, fileSize))) {
+        close();
+        return false;
+    }
+
+    if (created) {
+        MappedFileHeader header{makeHeader(magic, version, recordSize, userHeaderSize)};
+        memcpy(base, &header, sizeof(header));
+    }
+    opened = true;
+    return true;
+}
+
+bool MappedAppender::remap(size_t newCapacity) {
+    if (base) {
+        munmap(base, capacity);
+        base = nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(newCapacity)) != 0) return false;
+    void* mapped{mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)};
+    if (mapped == MAP_FAILED) return false;
+    base = static_cast<char*>(mapped);
+    capacity = newCapacity;
+    return true;
+}
+
+void MappedAppender::flush() {
+    if (base) msync(base, capacity, MS_ASYNC);
+}
+
+void MappedAppender::close() {
+    if (base) {
+        msync(base, capacity, MS_SYNC);
+        munmap(base, capacity);
+        base = nullptr;
+    }
+    if (fd >= 0) {
+        if (opened && ftruncate(fd, static_cast<off_t>(dataOffset() + recordCount * recordSize)) != 0) {
+            perror("MappedAppender: truncate failed");
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    opened = false;
+    capacity = 0;
+}
+
+MappedReader::MappedReader() : data(nullptr), length(0), recordCount(0) {}
+
+MappedReader::~MappedReader() {
+    close();
+}
+
+bool MappedReader::open(const string& path, const char* magic, uint32_t version, uint32_t recordSize) {
+    close();
+    int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MappedFileHeader)) {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(st.st_size);
+    void* mapped{mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0)};
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    data = static_cast<const char*>(mapped);
+
+    const auto* header{reinterpret_cast<const MappedFileHeader*>(data)};
+    size_t offset{sizeof(MappedFileHeader) + header->userHeaderSize};
+    if (!headerMatches(*header, magic, version, recordSize) || offset > length) {
+        close();
+        return false;
+    }
+    recordCount = min<uint64_t>(header->recordCount, (length - offset) / recordSize);
+    return true;
+}
+
+void MappedReader::close() {
+    if (data) {
+        munmap(const_cast<char*>(data), length);
+        data = nullptr;
+    }
+    length = 0;
+    recordCount = 0;
+}
+
+MappedRegion::MappedRegion() : bytes(nullptr), length(0) {}
+
+MappedRegion::~MappedRegion() {
+    close();
+}
+
+bool MappedRegion::open(const string& path) {
+    close();
+    int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped{mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0)};
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    bytes = static_cast<const char*>(mapped);
+    length = static_cast<size_t>(st.st_size);
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    return true;
+}
+
+void MappedRegion::close() {
+    if (bytes) {
+        munmap(const_cast<char*>(bytes), length);
+        bytes = nullptr;
+    }
+    length = 0;
+}
+
+SharedRegion::SharedRegion() : bytes(nullptr), length(0) {}
+
+SharedRegion::~SharedRegion() {
+    close();
+}
+
+bool SharedRegion::create(const string& name, size_t size) {
+    close();
+    string path{"/" + name};
+    int fd{shm_open(path.c_str(), O_CREAT | O_RDWR, 0644)};
+    if (fd < 0) return false;
+    // A region left by an earlier run is cut back to nothing first so it comes back zeroed.
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    void* mapped{mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)};
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        shm_unlink(path.c_str());
+        return false;
+    }
+    bytes = static_cast<char*>(mapped);
+    length = size;
+    owned = path;
+    return true;
+}
+
+bool SharedRegion::open(const string& name) {
+    close();
+    int fd{shm_open(("/" + name).c_str(), O_RDONLY, 0)};
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped{mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0)};
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    bytes = static_cast<char*>(mapped);
+    length = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void SharedRegion::close() {
+    if (bytes) {
+        munmap(bytes, length);
+        bytes = nullptr;
+    }
+    length = 0;
+    if (!owned.empty()) {
+        shm_unlink(owned.c_str());
+        owned.clear();
+    }
+}
+
+#else
+
+MappedAppender::MappedAppender()
+    : opened(false), created(false), recordSize(0), userHeaderSize(0), recordCount(0),
+      file(nullptr), mapping(nullptr), base(nullptr), capacity(0) {}
+
+MappedAppender::~MappedAppender() {
+    close();
+}
+
+bool MappedAppender::open(const string& path, const char* magic, uint32_t version,
+                          uint32_t recSize, uint32_t userHdrSize) {
+    close();
+    // Readers may map the file while it is being written.
+    HANDLE handle{CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    file = handle;
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(handle, &size)) {
+        close();
+        return false;
+    }
+
+    recordSize = recSize;
+    userHeaderSize = userHdrSize;
+    size_t fileSize{static_cast<size_t>(size.QuadPart)};
+
+    if (fileSize == 0) {
+        created = true;
+        recordCount = 0;
+    } else {
+        MappedFileHeader existing{};
+        DWORD read{0};
+        if (fileSize < sizeof(existing) || !ReadFile(handle, &existing, sizeof(existing), &read, nullptr) ||
+            read != sizeof(existing) || !headerMatches(existing, magic, version, recordSize) ||
+            existing.userHeaderSize != userHeaderSize) {
+            close();
+            return false;
+        }
+        created = false;
+        uint64_t onDisk{(fileSize - dataOffset()) / recordSize};
+        recordCount = min(existing.recordCount, onDisk);
+    }
+
+    size_t needed{dataOffset() + recordCount * recordSize};
+    if (!remap(max(needed + GROWTH_CHUNK, fileSize))) {
+        close();
+        return false;
+    }
+
+    if (created) {
+        // Space a mapping adds to a file is not guaranteed to read as zero.
+        MappedFileHeader header{makeHeader(magic, version, recordSize, userHeaderSize)};
+        memset(base, 0, dataOffset());
+        memcpy(base, &header, sizeof(header));
+    }
+    opened = true;
+    return true;
+}
+
+// A mapping larger than the file extends the file to its size.
+bool MappedAppender::remap(size_t newCapacity) {
+    if (base) {
+        UnmapViewOfFile(base);
+        base = nullptr;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    uint64_t size64{newCapacity};
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+                                 static_cast<DWORD>(size64), nullptr);
+    if (!mapping) return false;
+    base = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, newCapacity));
+    if (!base) return false;
+    capacity = newCapacity;
+    return true;
+}
+
+void MappedAppender::flush() {
+    if (base) FlushViewOfFile(base, 0);
+}
+
+void MappedAppender::close() {
+    if (base) {
+        FlushViewOfFile(base, 0);
+        UnmapViewOfFile(base);
+        base = nullptr;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file) {
+        if (opened) {
+            LARGE_INTEGER end{};
+            end.QuadPart = static_cast<LONGLONG>(dataOffset() + recordCount * recordSize);
+            if (!SetFilePointerEx(file, end, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+                fprintf(stderr, "MappedAppender: truncate failed\n");
+            }
+        }
+        CloseHandle(file);
+        file = nullptr;
+    }
+    opened = false;
+    capacity = 0;
+}
+
+namespace {
+// Maps a whole existing, non-empty file read-only; the view keeps the mapping alive, so both
+// handles are closed right away.
+const char* mapReadOnly(const string& path, size_t& length) {
+    HANDLE file{CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr)};
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping{CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+    void* view{MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)};
+    CloseHandle(mapping);
+    if (!view) return nullptr;
+    length = static_cast<size_t>(size.QuadPart);
+    return static_cast<const char*>(view);
+}
+}
+
+MappedReader::MappedReader() : data(nullptr), length(0), recordCount(0) {}
+
+MappedReader::~MappedReader() {
+    close();
+}
+
+bool MappedReader::open(const string& path, const char* magic, uint32_t version, uint32_t recordSize) {
+    close();
+    data = mapReadOnly(path, length);
+    if (!data) return false;
+    if (length < sizeof(MappedFileHeader)) {
+        close();
+        return false;
+    }
+
+    const auto* header{reinterpret_cast<const MappedFileHeader*>(data)};
+    size_t offset{sizeof(MappedFileHeader) + header->userHeaderSize};
+    if (!headerMatches(*header, magic, version, recordSize) || offset > length) {
+        close();
+        return false;
+    }
+    recordCount = min<uint64_t>(header->recordCount, (length - offset) / recordSize);
+    return true;
+}
+
+void MappedReader::close() {
+    if (data) {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    length = 0;
+    recordCount = 0;
+}
+
+MappedRegion::MappedRegion() : bytes(nullptr), length(0) {}
+
+MappedRegion::~MappedRegion() {
+    close();
+}
+
+bool MappedRegion::open(const string& path) {
+    close();
+    bytes = mapReadOnly(path, length);
+    return bytes != nullptr;
+}
+
+void MappedRegion::close() {
+    if (bytes) {
+        UnmapViewOfFile(bytes);
+        bytes = nullptr;
+    }
+    length = 0;
+}
+
+SharedRegion::SharedRegion() : bytes(nullptr), length(0), handle(nullptr) {}
+
+SharedRegion::~SharedRegion() {
+    close();
+}
+
+// The mapping lives as long as any process holds a handle or view, so there is no name to remove.
+bool SharedRegion::create(const string& name, size_t size) {
+    close();
+    string path{"Local\\" + name};
+    uint64_t size64{size};
+    handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+                                static_cast<DWORD>(size64), path.c_str());
+    if (!handle) return false;
+    bytes = static_cast<char*>(MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size));
+    if (!bytes) {
+        close();
+        return false;
+    }
+    // Reopening a mapping another process still holds keeps its contents.
+    memset(bytes, 0, size);
+    length = size;
+    return true;
+}
+
+bool SharedRegion::open(const string& name) {
+    close();
+    handle = OpenFileMappingA(FILE_MAP_READ, FALSE, ("Local\\" + name).c_str());
+    if (!handle) return false;
+    bytes = static_cast<char*>(MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0));
+    MEMORY_BASIC_INFORMATION info{};
+    if (!bytes || VirtualQuery(bytes, &info, sizeof(info)) == 0) {
+        close();
+        return false;
+    }
+    length = info.RegionSize;
+    return true;
+}
+
+void SharedRegion::close() {
+    if (bytes) {
+        UnmapViewOfFile(bytes);
+        bytes = nullptr;
+    }
+    if (handle) {
+        CloseHandle(handle);
+        handle = nullptr;
+    }
+    length = 0;
+}
+
+#endif
+
+void MappedAppender::append(const void* record) {
+    if (!opened) return;
+    size_t offset{dataOffset() + recordCount * recordSize};
+    if (offset + recordSize > capacity && !remap(capacity * 2)) {
+        opened = false;
+        return;
+    }
+    memcpy(base + offset, record, recordSize);
+    atomic_thread_fence(memory_order_release);
+    reinterpret_cast<MappedFileHeader*>(base)->recordCount = ++recordCount;
+}
+
+char* MappedAppender::userHeader() {
+    return base ? base + sizeof(MappedFileHeader) : nullptr;
+}
+
+const char* MappedReader::userHeader() const {
+    return data ? data + sizeof(MappedFileHeader) : nullptr;
+}
+
+const char* MappedReader::record(uint64_t index) const {
+    const auto* header{reinterpret_cast<const MappedFileHeader*>(data)};
+    return data + sizeof(MappedFileHeader) + header->userHeaderSize + index * header->recordSize;
+}
@@ -0,0 +1,131 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk layout shared by every fixed-record binary file:
+// [MappedFileHeader][user header (userHeaderSize bytes)][record 0][record 1]...
+struct MappedFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t userHeaderSize;
+    uint32_t reserved;
+    uint64_t recordCount;
+};
+
+// Append-only writer of fixed-size records. The file is memory-mapped (a file mapping on
+// Windows) and grown in chunks, so an append is a memcpy and the OS writes pages back in the
+// background. The header's recordCount follows every append, so records survive a crash of
+// the process. An existing file is only reopened if its magic, version and layout match.
+class MappedAppender {
+public:
+    MappedAppender();
+    ~MappedAppender();
+    MappedAppender(const MappedAppender&) = delete;
+    MappedAppender& operator=(const MappedAppender&) = delete;
+
+    bool open(const std::string& path, const char* magic, uint32_t version,
+              uint32_t recordSize, uint32_t userHeaderSize);
+    void append(const void* record);
+    void flush();
+    void close();
+
+    bool isOpen() const { return opened; }
+    bool isNew() const { return created; }
+    uint64_t size() const { return recordCount; }
+    char* userHeader();
+
+private:
+    bool opened;
+    bool created;
+    uint32_t recordSize;
+    uint32_t userHeaderSize;
+    uint64_t recordCount;
+#ifdef _WIN32
+    void* file;
+    void* mapping;
+#else
+    int fd;
+#endif
+    char* base;
+    size_t capacity;
+
+    bool remap(size_t newCapacity);
+    size_t dataOffset() const { return sizeof(MappedFileHeader) + userHeaderSize; }
+};
+
+// Read-only mapping of a whole file.
+class MappedRegion {
+public:
+    MappedRegion();
+    ~MappedRegion();
+    MappedRegion(const MappedRegion&) = delete;
+    MappedRegion& operator=(const MappedRegion&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return bytes != nullptr; }
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes;
+    size_t length;
+};
+
+// Named shared memory that other local processes map by the same name: a POSIX shm object
+// ("/name") or a pagefile-backed mapping ("Local\name") on Windows. create sizes and zero-fills
+// the region and removes the name again on close; open maps an existing region read-only.
+class SharedRegion {
+public:
+    SharedRegion();
+    ~SharedRegion();
+    SharedRegion(const SharedRegion&) = delete;
+    SharedRegion& operator=(const SharedRegion&) = delete;
+
+    bool create(const std::string& name, size_t size);
+    bool open(const std::string& name);
+    void close();
+
+    bool isOpen() const { return bytes != nullptr; }
+    char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    char* bytes;
+    size_t length;
+#ifdef _WIN32
+    void* handle;
+#else
+    // Name to unlink on close, set only for a region this process created.
+    std::string owned;
+#endif
+};
+
+// Read-only view over a file produced by MappedAppender.
+class MappedReader {
+public:
+    MappedReader();
+    ~MappedReader();
+    MappedReader(const MappedReader&) = delete;
+    MappedReader& operator=(const MappedReader&) = delete;
+
+    bool open(const std::string& path, const char* magic, uint32_t version, uint32_t recordSize);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    uint64_t size() const { return recordCount; }
+    const char* userHeader() const;
+    const char* record(uint64_t index) const;
+
+private:
+    const char* data;
+    size_t length;
+    uint64_t recordCount;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "MarketAnalytics.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+const double NANOS_PER_SECOND{1e9};
+}
+
+MarketAnalytics::MarketAnalytics(const AnalyticsConfig& analyticsConfig)
+    : config(analyticsConfig),
+      window(static_cast<int64_t>(analyticsConfig.windowSeconds * NANOS_PER_SECOND)),
+      trades(analyticsConfig.windowCapacity),
+      spreads(analyticsConfig.windowCapacity) {}
+
+void MarketAnalytics::advanceClock(int64_t time) {
+    now = max(now, time);
+}
+
+void MarketAnalytics::onTrade(double price, double quantity) {
+    double squaredReturn{0.0};
+    if (lastTradePrice > 0 && price > 0) {
+        double r{log(price / lastTradePrice)};
+        squaredReturn = r * r;
+    }
+    lastTradePrice = price;
+
+    if (trades.full()) trades.grow();
+    trades.push(TradeSample{now, quantity, price * quantity, squaredReturn});
+    windowQuantity += quantity;
+    windowNotional += price * quantity;
+    windowSquaredReturns += squaredReturn;
+
+    expire();
+    refreshWindows();
+}
+
+void MarketAnalytics::onQuote(double bidPrice, double bidQuantity, double askPrice, double askQuantity,
+                              double topBidQuantity, double topAskQuantity) {
+    bool twoSided{bidPrice > 0 && askPrice > 0};
+    current.microPrice = (twoSided && bidQuantity + askQuantity > 0)
+        ? (bidPrice * askQuantity + askPrice * bidQuantity) / (bidQuantity + askQuantity)
+        : 0.0;
+    double depth{topBidQuantity + topAskQuantity};
+    current.orderImbalance = depth > 0 ? (topBidQuantity - topAskQuantity) / depth : 0.0;
+
+    closeSpreadSegment();
+    hasSpread = twoSided;
+    currentSpread = twoSided ? askPrice - bidPrice : 0.0;
+
+    expire();
+    refreshWindows();
+}
+
+// The spread in force since spreadSince becomes one weighted segment of the window.
+void MarketAnalytics::closeSpreadSegment() {
+    if (hasSpread && now > spreadSince) {
+        double duration{(now - spreadSince) / NANOS_PER_SECOND};
+        if (spreads.full()) spreads.grow();
+        spreads.push(SpreadSample{now, duration, currentSpread * duration});
+        windowDuration += duration;
+        windowWeightedSpread += currentSpread * duration;
+    }
+    spreadSince = now;
+}
+
+void MarketAnalytics::expire() {
+    int64_t cutoff{now - window};
+    while (!trades.empty() && trades.front().time < cutoff) {
+        windowQuantity -= trades.front().quantity;
+        windowNotional -= trades.front().notional;
+        windowSquaredReturns -= trades.front().squaredReturn;
+        trades.pop();
+    }
+    while (!spreads.empty() && spreads.front().time < cutoff) {
+        windowDuration -= spreads.front().duration;
+        windowWeightedSpread -= spreads.front().weighted;
+        spreads.pop();
+    }
+
+    // Reset once empty so subtraction error cannot accumulate across windows.
+    if (trades.empty()) {
+        windowQuantity = 0.0;
+        windowNotional = 0.0;
+        windowSquaredReturns = 0.0;
+    }
+    if (spreads.empty()) {
+        windowDuration = 0.0;
+        windowWeightedSpread = 0.0;
+    }
+}
+
+void MarketAnalytics::refreshWindows() {
+    current.rollingVWAP = windowQuantity > 0 ? windowNotional / windowQuantity : 0.0;
+    current.realizedVolatility = sqrt(max(0.0, windowSquaredReturns));
+    current.tradeArrivalRate = config.windowSeconds > 0 ? trades.size() / config.windowSeconds : 0.0;
+
+    // The segment still open at the current spread counts up to now.
+    double open{hasSpread ? (now - spreadSince) / NANOS_PER_SECOND : 0.0};
+    double duration{windowDuration + open};
+    current.timeWeightedSpread = duration > 0 ? (windowWeightedSpread + currentSpread * open) / duration : currentSpread;
+}
+
+AnalyticsState MarketAnalytics::getState() const {
+    return AnalyticsState{now, windowQuantity, windowNotional, windowSquaredReturns, lastTradePrice, windowDuration,
+                          windowWeightedSpread, currentSpread, spreadSince, hasSpread ? uint8_t{1} : uint8_t{0}, {},
+                          current};
+}
+
+void MarketAnalytics::restore(const AnalyticsState& state, const vector<TradeSample>& tradeSamples,
+                              const vector<SpreadSample>& spreadSamples) {
+    now = state.now;
+    windowQuantity = state.windowQuantity;
+    windowNotional = state.windowNotional;
+    windowSquaredReturns = state.windowSquaredReturns;
+    lastTradePrice = state.lastTradePrice;
+    windowDuration = state.windowDuration;
+    windowWeightedSpread = state.windowWeightedSpread;
+    currentSpread = state.currentSpread;
+    spreadSince = state.spreadSince;
+    hasSpread = state.hasSpread != 0;
+    current = state.current;
+
+    trades.clear();
+    for (const auto& sample : tradeSamples) {
+        if (trades.full()) trades.grow();
+        trades.push(sample);
+    }
+    spreads.clear();
+    for (const auto& sample : spreadSamples) {
+        if (spreads.full()) spreads.grow();
+        spreads.push(sample);
+    }
+}
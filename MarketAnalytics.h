@@ -0,0 +1,146 @@
+#ifndef MARKET_ANALYTICS_H
+#define MARKET_ANALYTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AnalyticsConfig {
+    size_t imbalanceLevels{5};
+    double windowSeconds{60.0};
+    // Events a window holds before its buffer first grows. A full buffer doubles, so every
+    // event inside windowSeconds counts however busy the asset is.
+    size_t windowCapacity{4096};
+};
+
+// FIFO over a preallocated buffer. push needs a free slot; grow() makes room when full.
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity = 1) : slots(capacity > 0 ? capacity : 1) {}
+
+    bool empty() const { return count == 0; }
+    bool full() const { return count == slots.size(); }
+    size_t size() const { return count; }
+    const T& front() const { return slots[head]; }
+    T& back() { return slots[(head + count - 1) % slots.size()]; }
+    // index 0 is the oldest element.
+    const T& at(size_t index) const { return slots[(head + index) % slots.size()]; }
+
+    void push(const T& value) {
+        slots[(head + count) % slots.size()] = value;
+        ++count;
+    }
+    void pop() {
+        head = (head + 1) % slots.size();
+        --count;
+    }
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+    // Doubles the capacity, keeping the elements in order.
+    void grow() {
+        std::vector<T> larger(slots.size() * 2);
+        for (size_t i = 0; i < count; ++i) larger[i] = at(i);
+        slots.swap(larger);
+        head = 0;
+    }
+
+private:
+    std::vector<T> slots;
+    size_t head{0};
+    size_t count{0};
+};
+
+// Output of MarketAnalytics, copied into OrderBookStatistics after each book update.
+struct AnalyticsSnapshot {
+    double microPrice{0.0};
+    double orderImbalance{0.0};
+    double rollingVWAP{0.0};
+    double realizedVolatility{0.0};
+    double timeWeightedSpread{0.0};
+    double tradeArrivalRate{0.0};
+};
+
+// Everything of a MarketAnalytics besides its window samples, for checkpoints. The running sums
+// are kept as they are rather than summed again, so a restored instance goes on bit for bit.
+struct AnalyticsState {
+    int64_t now;
+    double windowQuantity;
+    double windowNotional;
+    double windowSquaredReturns;
+    double lastTradePrice;
+    double windowDuration;
+    double windowWeightedSpread;
+    double currentSpread;
+    int64_t spreadSince;
+    uint8_t hasSpread;
+    uint8_t reserved[7];
+    AnalyticsSnapshot current;
+};
+
+struct TradeSample {
+    int64_t time;
+    double quantity;
+    double notional;
+    double squaredReturn;
+};
+
+struct SpreadSample {
+    int64_t time;
+    double duration;
+    double weighted;
+};
+
+// Streaming per-asset analytics. Every event costs O(1) amortized: windows keep running
+// sums and only the entries that fall out of the window are subtracted.
+// Time is event time in nanoseconds (order timestamps), so replays give identical values.
+class MarketAnalytics {
+public:
+    explicit MarketAnalytics(const AnalyticsConfig& config = AnalyticsConfig{});
+
+    void advanceClock(int64_t time);
+    int64_t clock() const { return now; }
+
+    void onTrade(double price, double quantity);
+    // topBidQuantity/topAskQuantity are summed over config.imbalanceLevels levels.
+    void onQuote(double bidPrice, double bidQuantity, double askPrice, double askQuantity,
+                 double topBidQuantity, double topAskQuantity);
+
+    const AnalyticsSnapshot& snapshot() const { return current; }
+    const AnalyticsConfig& getConfig() const { return config; }
+
+    // Saved state and window samples, oldest first; restore replaces both.
+    AnalyticsState getState() const;
+    const RingBuffer<TradeSample>& getTrades() const { return trades; }
+    const RingBuffer<SpreadSample>& getSpreads() const { return spreads; }
+    void restore(const AnalyticsState& state, const std::vector<TradeSample>& tradeSamples,
+                 const std::vector<SpreadSample>& spreadSamples);
+
+private:
+    AnalyticsConfig config;
+    int64_t window;
+    int64_t now{0};
+
+    RingBuffer<TradeSample> trades;
+    double windowQuantity{0.0};
+    double windowNotional{0.0};
+    double windowSquaredReturns{0.0};
+    double lastTradePrice{0.0};
+
+    RingBuffer<SpreadSample> spreads;
+    double windowDuration{0.0};
+    double windowWeightedSpread{0.0};
+    double currentSpread{0.0};
+    int64_t spreadSince{0};
+    bool hasSpread{false};
+
+    AnalyticsSnapshot current;
+
+    void expire();
+    void closeSpreadSegment();
+    void refreshWindows();
+};
+
+#endif
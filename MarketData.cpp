@@ -0,0 +1,61 @@
+#include "MarketData.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+bool MarketDataView::open(const string& name) {
+    if (!region.open(name)) return false;
+    const MarketDataHeader* h{header()};
+    if (region.size() < sizeof(MarketDataHeader) || memcmp(h->magic, MARKET_DATA_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != MARKET_DATA_VERSION || h->slotSize != sizeof(MarketDataSlot) ||
+        h->depthLevels != MARKET_DATA_DEPTH ||
+        region.size() < sizeof(MarketDataHeader) + static_cast<size_t>(h->slotCount) * sizeof(MarketDataSlot)) {
+        cerr << "Shared region " << name << " is not a version " << MARKET_DATA_VERSION << " market data region" << endl;
+        region.close();
+        return false;
+    }
+    return true;
+}
+
+uint32_t MarketDataView::assetCount() const {
+    if (!isOpen()) return 0;
+    return min(header()->assetCount.load(memory_order_acquire), header()->slotCount);
+}
+
+bool MarketDataView::read(uint32_t index, MarketDataSnapshot& snapshot, int maxAttempts) const {
+    if (index >= assetCount()) return false;
+    const MarketDataSlot& source{*slot(index)};
+    MarketDataSlot copy;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        uint64_t before{source.sequence.load(memory_order_acquire)};
+        if (before & 1) continue;
+        // The payload races with the writer by design; a torn copy is caught by the sequence check.
+        memcpy(static_cast<void*>(copy.symbol), source.symbol, sizeof(MarketDataSlot) - offsetof(MarketDataSlot, symbol));
+        atomic_thread_fence(memory_order_acquire);
+        if (source.sequence.load(memory_order_relaxed) != before) continue;
+
+        snapshot.symbol.assign(copy.symbol, strnlen(copy.symbol, sizeof(copy.symbol)));
+        snapshot.engineNanos = copy.engineNanos;
+        snapshot.publishNanos = copy.publishNanos;
+        snapshot.updates = copy.updates;
+        snapshot.bidLevels = min(copy.bidLevels, MARKET_DATA_DEPTH);
+        snapshot.askLevels = min(copy.askLevels, MARKET_DATA_DEPTH);
+        memcpy(snapshot.bids, copy.bids, sizeof(copy.bids));
+        memcpy(snapshot.asks, copy.asks, sizeof(copy.asks));
+        snapshot.statistics = copy.statistics;
+        return true;
+    }
+    return false;
+}
+
+int MarketDataView::find(const string& symbol) const {
+    uint32_t count{assetCount()};
+    for (uint32_t i = 0; i < count; ++i) {
+        const char* name{slot(i)->symbol};
+        if (symbol == string(name, strnlen(name, MARKET_DATA_SYMBOL_LENGTH))) return static_cast<int>(i);
+    }
+    return -1;
+}
@@ -0,0 +1,124 @@
+#ifndef MARKET_DATA_H
+#define MARKET_DATA_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "MappedFile.h"
+
+// Shared-memory market data for local readers (dashboards, strategy processes). This header
+// only depends on MappedFile.h so other programs can include it. The region is
+//   [MarketDataHeader][MarketDataSlot 0][MarketDataSlot 1]...[MarketDataSlot slotCount - 1]
+// in native byte order, one 512-byte slot per asset in the order the assets first updated.
+// assetCount only grows, and a slot's symbol is written before it is counted.
+//
+// Each slot is a seqlock written by one thread at a time (the publisher serializes writers):
+// sequence is odd while the slot is being rewritten and grows by two per update. A reader
+// loads sequence, copies the slot, loads sequence again and keeps the copy only when both
+// loads are the same even value. Readers never write to the region, so they cannot stall the engine.
+
+const char* const MARKET_DATA_REGION{"lob_market_data"};
+const char MARKET_DATA_MAGIC[8]{'L', 'O', 'B', 'M', 'D', 'A', 'T', '1'};
+const uint32_t MARKET_DATA_VERSION{1};
+const uint32_t MARKET_DATA_DEPTH{10};
+const uint32_t MARKET_DATA_SYMBOL_LENGTH{16};
+
+struct MarketDataHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slotSize;
+    uint32_t slotCount;
+    uint32_t depthLevels;
+    std::atomic<uint32_t> assetCount;
+    uint32_t reserved;
+    int64_t createdNanos;
+    uint8_t padding[24];
+};
+
+struct MarketDataLevel {
+    double price;
+    double quantity;
+};
+
+// The fields of OrderBookStatistics, in fixed-width types.
+struct MarketDataStatistics {
+    double averageExecutedPrice;
+    double totalTradedQuantity;
+    double totalTradedAmount;
+    double bidPrice;
+    double askPrice;
+    double midPrice;
+    double bidAskSpread;
+    int32_t bidDepth;
+    int32_t askDepth;
+    double totalBidAmount;
+    double totalAskAmount;
+    double microPrice;
+    double orderImbalance;
+    double rollingVWAP;
+    double realizedVolatility;
+    double timeWeightedSpread;
+    double tradeArrivalRate;
+    double lastTradePrice;
+};
+
+// engineNanos is the engine clock at the update and publishNanos the system clock when it
+// was written, so a reader can tell how stale a slot is. Bids run from the best price down,
+// asks from the best price up; only the first bidLevels/askLevels entries are meaningful.
+struct alignas(64) MarketDataSlot {
+    std::atomic<uint64_t> sequence;
+    char symbol[MARKET_DATA_SYMBOL_LENGTH];
+    int64_t engineNanos;
+    int64_t publishNanos;
+    uint64_t updates;
+    uint32_t bidLevels;
+    uint32_t askLevels;
+    MarketDataLevel bids[MARKET_DATA_DEPTH];
+    MarketDataLevel asks[MARKET_DATA_DEPTH];
+    MarketDataStatistics statistics;
+};
+
+static_assert(sizeof(MarketDataHeader) == 64, "MarketDataHeader layout is part of the region format");
+static_assert(sizeof(MarketDataSlot) == 512, "MarketDataSlot layout is part of the region format");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock must not need a lock");
+static_assert(std::is_standard_layout<MarketDataSlot>::value, "MarketDataSlot is read by other processes");
+
+// A consistent copy of one slot, without the sequence.
+struct MarketDataSnapshot {
+    std::string symbol;
+    int64_t engineNanos{0};
+    int64_t publishNanos{0};
+    uint64_t updates{0};
+    uint32_t bidLevels{0};
+    uint32_t askLevels{0};
+    MarketDataLevel bids[MARKET_DATA_DEPTH]{};
+    MarketDataLevel asks[MARKET_DATA_DEPTH]{};
+    MarketDataStatistics statistics{};
+};
+
+// Read-only, lock-free view of a region published by MarketDataPublisher.
+class MarketDataView {
+public:
+    bool open(const std::string& name = MARKET_DATA_REGION);
+    void close() { region.close(); }
+    bool isOpen() const { return region.isOpen(); }
+
+    uint32_t assetCount() const;
+    // Retries while the writer is inside the slot; false for an unused slot or when the
+    // writer kept it busy for maxAttempts tries.
+    bool read(uint32_t index, MarketDataSnapshot& snapshot, int maxAttempts = 1000) const;
+    // Slot index of symbol, or -1.
+    int find(const std::string& symbol) const;
+
+private:
+    SharedRegion region;
+
+    const MarketDataHeader* header() const { return reinterpret_cast<const MarketDataHeader*>(region.data()); }
+    const MarketDataSlot* slot(uint32_t index) const {
+        return reinterpret_cast<const MarketDataSlot*>(region.data() + sizeof(MarketDataHeader)) + index;
+    }
+};
+
+#endif
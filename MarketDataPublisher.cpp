@@ -0,0 +1,92 @@
+#include "MarketDataPublisher.h"
+#include <cstring>
+
+using namespace std;
+
+namespace {
+MarketDataStatistics toShared(const OrderBookStatistics& stats) {
+    return MarketDataStatistics{stats.averageExecutedPrice, stats.totalTradedQuantity, stats.totalTradedAmount,
+                                stats.bidPrice, stats.askPrice, stats.midPrice, stats.bidAskSpread,
+                                stats.bidDepth, stats.askDepth, stats.totalBidAmount, stats.totalAskAmount,
+                                stats.microPrice, stats.orderImbalance, stats.rollingVWAP, stats.realizedVolatility,
+                                stats.timeWeightedSpread, stats.tradeArrivalRate, stats.lastTradePrice};
+}
+
+template <typename Book>
+uint32_t copyLevels(const Book* book, MarketDataLevel* levels) {
+    uint32_t count{0};
+    if (!book) return count;
+    for (auto it = book->begin(); it != book->end() && count < MARKET_DATA_DEPTH; ++it, ++count) {
+        levels[count] = MarketDataLevel{it->first, it->second.quantity};
+    }
+    return count;
+}
+}
+
+MarketDataPublisher::MarketDataPublisher(const string& name, uint32_t assetCapacity) {
+    if (!region.create(name, sizeof(MarketDataHeader) + static_cast<size_t>(assetCapacity) * sizeof(MarketDataSlot))) {
+        cerr << "Error: unable to create shared market data region " << name << endl;
+        return;
+    }
+    capacity = assetCapacity;
+    MarketDataHeader* h{header()};
+    memcpy(h->magic, MARKET_DATA_MAGIC, sizeof(h->magic));
+    h->version = MARKET_DATA_VERSION;
+    h->slotSize = sizeof(MarketDataSlot);
+    h->slotCount = capacity;
+    h->depthLevels = MARKET_DATA_DEPTH;
+    h->createdNanos = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    h->assetCount.store(0, memory_order_release);
+}
+
+void MarketDataPublisher::attach(OrderBookManager& manager) {
+    if (!isOpen()) return;
+    auto publishFrom{[this, &manager](const string& asset, const OrderBookStatistics& stats) {
+        auto bids{manager.getBidBooks().find(asset)};
+        auto asks{manager.getAskBooks().find(asset)};
+        publish(asset, stats, bids != manager.getBidBooks().end() ? &bids->second : nullptr,
+                asks != manager.getAskBooks().end() ? &asks->second : nullptr, manager.getClock());
+    }};
+    for (const auto& [asset, stats] : manager.getStatistics()) publishFrom(asset, stats);
+    manager.addStatisticsListener(publishFrom);
+}
+
+int MarketDataPublisher::slotFor(const string& asset) {
+    auto it{slots.find(asset)};
+    if (it != slots.end()) return static_cast<int>(it->second);
+    if (slots.size() >= capacity) {
+        if (!reportedFull) cerr << "Market data region is full; " << asset << " is not published" << endl;
+        reportedFull = true;
+        return -1;
+    }
+
+    uint32_t index{static_cast<uint32_t>(slots.size())};
+    MarketDataSlot& s{*slot(index)};
+    strncpy(s.symbol, asset.c_str(), sizeof(s.symbol) - 1);
+    // Readers only look at slots below assetCount, so the symbol is in place before they can.
+    header()->assetCount.store(index + 1, memory_order_release);
+    slots.emplace(asset, index);
+    return static_cast<int>(index);
+}
+
+void MarketDataPublisher::publish(const string& asset, const OrderBookStatistics& stats, const BidBook* bids,
+                                  const AskBook* asks, int64_t engineNanos) {
+    if (!isOpen()) return;
+    lock_guard<mutex> lock(writeMutex);
+    int index{slotFor(asset)};
+    if (index < 0) return;
+
+    MarketDataSlot& s{*slot(static_cast<uint32_t>(index))};
+    uint64_t sequence{s.sequence.load(memory_order_relaxed)};
+    s.sequence.store(sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    s.engineNanos = engineNanos;
+    s.publishNanos = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    ++s.updates;
+    s.bidLevels = copyLevels(bids, s.bids);
+    s.askLevels = copyLevels(asks, s.asks);
+    s.statistics = toShared(stats);
+
+    s.sequence.store(sequence + 2, memory_order_release);
+}
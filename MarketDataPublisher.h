@@ -0,0 +1,42 @@
+#ifndef MARKET_DATA_PUBLISHER_H
+#define MARKET_DATA_PUBLISHER_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "MarketData.h"
+#include "OrderBookManager.h"
+
+// Writes each asset's top of book, MARKET_DATA_DEPTH levels per side and statistics into the
+// shared region described in MarketData.h. A publish is a seqlock write of one 512-byte slot:
+// it never waits on readers, and readers cost the engine nothing. Writers take turns on a
+// mutex, so updates from several threads never interleave within a slot.
+class MarketDataPublisher {
+public:
+    explicit MarketDataPublisher(const std::string& name = MARKET_DATA_REGION, uint32_t assetCapacity = 64);
+
+    bool isOpen() const { return region.isOpen(); }
+    // Publishes every asset the manager already has, then each of its statistics updates from
+    // the thread that makes them.
+    void attach(OrderBookManager& manager);
+    void publish(const std::string& asset, const OrderBookStatistics& stats, const BidBook* bids,
+                 const AskBook* asks, int64_t engineNanos);
+
+private:
+    SharedRegion region;
+    uint32_t capacity{0};
+    // Guards slots, reportedFull and every slot write.
+    std::mutex writeMutex;
+    std::unordered_map<std::string, uint32_t> slots;
+    bool reportedFull{false};
+
+    MarketDataHeader* header() { return reinterpret_cast<MarketDataHeader*>(region.data()); }
+    MarketDataSlot* slot(uint32_t index) {
+        return reinterpret_cast<MarketDataSlot*>(region.data() + sizeof(MarketDataHeader)) + index;
+    }
+    // -1 once every slot is taken.
+    int slotFor(const std::string& asset);
+};
+
+#endif
@@ -0,0 +1,75 @@
+// Prints the market data the engine publishes in shared memory, without touching the engine.
+// Usage: MarketDataReader [symbol] [--once] [--interval milliseconds] [--region name]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "MarketData.h"
+
+using namespace std;
+
+namespace {
+void printSnapshot(const MarketDataSnapshot& snapshot) {
+    const MarketDataStatistics& stats{snapshot.statistics};
+    int64_t now{chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count()};
+    cout << "\n" << snapshot.symbol << "  update " << snapshot.updates << ", "
+         << (now - snapshot.publishNanos) / 1000000 << " ms old\n";
+    cout << fixed << setprecision(2);
+    cout << "bid " << stats.bidPrice << "  ask " << stats.askPrice << "  mid " << stats.midPrice
+         << "  spread " << stats.bidAskSpread << "  last " << stats.lastTradePrice << "\n";
+    cout << "traded " << stats.totalTradedQuantity << " @ " << stats.averageExecutedPrice
+         << "  VWAP " << stats.rollingVWAP << "  imbalance " << stats.orderImbalance << "\n";
+    cout << setw(15) << "BID VOLUME" << setw(12) << "BID" << setw(12) << "ASK" << setw(15) << "ASK VOLUME" << "\n";
+    uint32_t rows{max(snapshot.bidLevels, snapshot.askLevels)};
+    for (uint32_t i = 0; i < rows; ++i) {
+        if (i < snapshot.bidLevels) {
+            cout << setw(15) << snapshot.bids[i].quantity << setw(12) << snapshot.bids[i].price;
+        } else {
+            cout << setw(27) << "";
+        }
+        if (i < snapshot.askLevels) cout << setw(12) << snapshot.asks[i].price << setw(15) << snapshot.asks[i].quantity;
+        cout << "\n";
+    }
+}
+}
+
+int main(int argc, char* argv[]) {
+    string symbol;
+    string region{MARKET_DATA_REGION};
+    bool once{false};
+    int intervalMillis{1000};
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--once") == 0) {
+            once = true;
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            intervalMillis = max(atoi(argv[++i]), 1);
+        } else if (strcmp(argv[i], "--region") == 0 && i + 1 < argc) {
+            region = argv[++i];
+        } else {
+            symbol = argv[i];
+        }
+    }
+
+    MarketDataView view;
+    if (!view.open(region)) {
+        cerr << "No market data published; is LOB_simulation running?" << endl;
+        return 1;
+    }
+
+    MarketDataSnapshot snapshot;
+    while (true) {
+        for (uint32_t i = 0; i < view.assetCount(); ++i) {
+            if (!view.read(i, snapshot)) continue;
+            if (symbol.empty() || snapshot.symbol == symbol) printSnapshot(snapshot);
+        }
+        cout.flush();
+        if (once) break;
+        this_thread::sleep_for(chrono::milliseconds(intervalMillis));
+    }
+    return 0;
+}
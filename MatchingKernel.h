@@ -0,0 +1,97 @@
+#ifndef MATCHING_KERNEL_H
+#define MATCHING_KERNEL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+// Side policies for OrderBookManager's matching kernel, which is written once and instantiated
+// per side, so an order picks its side once and nothing inside the match tests it again.
+// Compare keys the side's book (BidBook, AskBook); own() picks the side's member of a bid/ask
+// pair (books, depth), and Opposite is the side a new order trades against.
+struct SellSide;
+
+struct BuySide {
+    using Compare = std::greater<>;
+    using Opposite = SellSide;
+    static constexpr bool IS_BUY{true};
+
+    template <typename Bid, typename Ask>
+    static Bid& own(Bid& bid, Ask&) { return bid; }
+    template <typename Book>
+    static auto best(Book& book) { return book.begin(); }
+    // True when a resting level of the opposite side at best trades against limit.
+    static bool crosses(double limit, double best) { return !Compare{}(best, limit); }
+    // Limits move to the tick on the passive side of the requested price.
+    static constexpr int64_t toTick(int64_t price, int64_t tick) { return price / tick * tick; }
+};
+
+struct SellSide {
+    using Compare = std::less<>;
+    using Opposite = BuySide;
+    static constexpr bool IS_BUY{false};
+
+    template <typename Bid, typename Ask>
+    static Ask& own(Bid&, Ask& ask) { return ask; }
+    template <typename Book>
+    static auto best(Book& book) { return book.begin(); }
+    static bool crosses(double limit, double best) { return !Compare{}(best, limit); }
+    static constexpr int64_t toTick(int64_t price, int64_t tick) { return (price + tick - 1) / tick * tick; }
+};
+
+// The matching loop every book shares. An order of Side with limit takes the opposite book's
+// levels from the best one at their resting prices; onFill(price, quantity, restingId) sees each
+// fill before the level shrinks or is erased. Returns the quantity left to rest.
+template <typename Side, typename Book, typename OnFill>
+double sweep(Book& book, double limit, double quantity, OnFill&& onFill) {
+    using Opposite = typename Side::Opposite;
+    double remaining{quantity};
+    while (remaining > 0 && !book.empty()) {
+        auto level{Opposite::best(book)};
+        if (!Side::crosses(limit, level->first)) break;
+
+        double execQuantity{std::min(remaining, level->second.quantity)};
+        onFill(level->first, execQuantity, level->second.id);
+        remaining -= execQuantity;
+
+        if (level->second.quantity > execQuantity) {
+            level->second.quantity -= execQuantity;
+            level->second.executedQuantity += execQuantity;
+        } else {
+            book.erase(level);
+        }
+    }
+    return remaining;
+}
+
+// Adds quantity to the level at price, creating it under the next number of levelSequence.
+template <typename Book>
+typename Book::mapped_type& restAt(Book& book, int id, double price, double quantity,
+                                   std::chrono::system_clock::time_point dateTime, uint64_t& levelSequence) {
+    auto it{book.find(price)};
+    if (it != book.end()) {
+        it->second.quantity += quantity;
+        it->second.id = id;
+        it->second.timestamp = dateTime;
+    } else {
+        it = book.emplace(price, typename Book::mapped_type{id, price, quantity, dateTime, ++levelSequence}).first;
+    }
+    it->second.queuedQuantity += quantity;
+    return it->second;
+}
+
+// Tick and lot of an instrument known at build time, in PRICE_SCALE and QUANTITY_SCALE units,
+// for processNewOrder<Instrument>(OrderMessage): limits and triggers move to the tick, and
+// quantities round down to whole lots (an order under one lot is dropped).
+template <int64_t Tick, int64_t Lot>
+struct FixedInstrument {
+    static_assert(Tick > 0 && Lot > 0, "tick and lot must be positive");
+    static constexpr int64_t TICK{Tick};
+    static constexpr int64_t LOT{Lot};
+};
+
+// Every price and quantity a message can carry; the rounding compiles away.
+using AnyInstrument = FixedInstrument<1, 1>;
+
+#endif
@@ -0,0 +1,44 @@
+#include "MemoryStats.h"
+
+using namespace std;
+
+MemoryStats& MemoryStats::operator+=(const MemoryStats& other) {
+    bytesInUse += other.bytesInUse;
+    peakBytes += other.peakBytes;
+    totalBytes += other.totalBytes;
+    allocations += other.allocations;
+    deallocations += other.deallocations;
+    return *this;
+}
+
+CountingResource::CountingResource(pmr::memory_resource* upstreamResource) : upstream(upstreamResource) {}
+
+MemoryStats CountingResource::stats() const {
+    MemoryStats s;
+    s.bytesInUse = bytesInUse.load(memory_order_relaxed);
+    s.peakBytes = peakBytes.load(memory_order_relaxed);
+    s.totalBytes = totalBytes.load(memory_order_relaxed);
+    s.allocations = allocations.load(memory_order_relaxed);
+    s.deallocations = deallocations.load(memory_order_relaxed);
+    return s;
+}
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    void* p{upstream->allocate(bytes, alignment)};
+    size_t inUse{bytesInUse.fetch_add(bytes, memory_order_relaxed) + bytes};
+    size_t peak{peakBytes.load(memory_order_relaxed)};
+    while (inUse > peak && !peakBytes.compare_exchange_weak(peak, inUse, memory_order_relaxed)) {}
+    totalBytes.fetch_add(bytes, memory_order_relaxed);
+    allocations.fetch_add(1, memory_order_relaxed);
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    upstream->deallocate(p, bytes, alignment);
+    bytesInUse.fetch_sub(bytes, memory_order_relaxed);
+    deallocations.fetch_add(1, memory_order_relaxed);
+}
+
+bool CountingResource::do_is_equal(const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,52 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+struct MemoryStats {
+    size_t bytesInUse{0};
+    size_t peakBytes{0};
+    size_t totalBytes{0};
+    size_t allocations{0};
+    size_t deallocations{0};
+
+    MemoryStats& operator+=(const MemoryStats& other);
+};
+
+// Pass-through memory resource that counts what goes to its upstream.
+// Counters are relaxed atomics so a reporting thread can read them while the owner allocates.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    MemoryStats stats() const;
+
+private:
+    std::pmr::memory_resource* upstream;
+    std::atomic<size_t> bytesInUse{0};
+    std::atomic<size_t> peakBytes{0};
+    std::atomic<size_t> totalBytes{0};
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> deallocations{0};
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+// Per-asset book storage: levels come from a pool that recycles freed map nodes, and the
+// pool takes its chunks from the heap. `levels` counts nodes held by the books, `reserved`
+// counts what the pool has actually taken from the system.
+struct BookMemory {
+    CountingResource reserved;
+    std::pmr::unsynchronized_pool_resource pool;
+    CountingResource levels;
+
+    BookMemory() : pool(&reserved), levels(&pool) {}
+    BookMemory(const BookMemory&) = delete;
+    BookMemory& operator=(const BookMemory&) = delete;
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include "MonteCarloRisk.h"
+#include "Portfolio.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+namespace {
+const double TRADING_DAYS{252.0};
+const double TWO_PI{6.283185307179586};
+// Scenarios revalued together; a multiple of the lane width.
+const size_t BLOCK{64};
+
+#if defined(__GNUC__)
+typedef double Lanes __attribute__((vector_size(32)));
+const size_t LANE_WIDTH{sizeof(Lanes) / sizeof(double)};
+
+// out[i] += factor * in[i], count a multiple of LANE_WIDTH.
+void multiplyAdd(double* out, const double* in, double factor, size_t count) {
+    Lanes scale{factor, factor, factor, factor};
+    for (size_t i = 0; i < count; i += LANE_WIDTH) {
+        Lanes a, b;
+        memcpy(&a, out + i, sizeof(a));
+        memcpy(&b, in + i, sizeof(b));
+        a += scale * b;
+        memcpy(out + i, &a, sizeof(a));
+    }
+}
+
+// Lane-wise partial sums folded in a fixed order, so equal inputs give equal totals.
+double sum(const double* values, size_t count) {
+    Lanes total{};
+    size_t i{0};
+    for (; i + LANE_WIDTH <= count; i += LANE_WIDTH) {
+        Lanes v;
+        memcpy(&v, values + i, sizeof(v));
+        total += v;
+    }
+    double result{(total[0] + total[1]) + (total[2] + total[3])};
+    for (; i < count; ++i) result += values[i];
+    return result;
+}
+#else
+void multiplyAdd(double* out, const double* in, double factor, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] += factor * in[i];
+}
+
+double sum(const double* values, size_t count) {
+    double result{0.0};
+    for (size_t i = 0; i < count; ++i) result += values[i];
+    return result;
+}
+#endif
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"): the output
+// is a pure function of the counter and key, so any scenario can be drawn on any thread.
+struct Philox {
+    uint32_t key[2];
+
+    void generate(uint32_t counter[4]) const {
+        uint32_t k0{key[0]}, k1{key[1]};
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0{uint64_t{0xD2511F53} * counter[0]};
+            uint64_t p1{uint64_t{0xCD9E8D57} * counter[2]};
+            uint32_t c0{static_cast<uint32_t>(p1 >> 32) ^ counter[1] ^ k0};
+            uint32_t c2{static_cast<uint32_t>(p0 >> 32) ^ counter[3] ^ k1};
+            counter[0] = c0;
+            counter[1] = static_cast<uint32_t>(p1);
+            counter[2] = c2;
+            counter[3] = static_cast<uint32_t>(p0);
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+    }
+};
+
+// Writes the assetCount standard normals of one scenario with the given stride.
+void drawNormals(const Philox& rng, uint64_t scenario, size_t assetCount, double* out, size_t stride) {
+    const double scale{1.0 / 4294967296.0};
+    for (size_t draw = 0; draw * 4 < assetCount; ++draw) {
+        uint32_t counter[4]{static_cast<uint32_t>(scenario), static_cast<uint32_t>(scenario >> 32),
+                            static_cast<uint32_t>(draw), 0};
+        rng.generate(counter);
+        for (size_t pair = 0; pair < 2; ++pair) {
+            double u1{(counter[2 * pair] + 1.0) * scale};
+            double u2{counter[2 * pair + 1] * scale};
+            double radius{sqrt(-2.0 * log(u1))};
+            size_t asset{draw * 4 + pair * 2};
+            if (asset < assetCount) out[asset * stride] = radius * cos(TWO_PI * u2);
+            if (asset + 1 < assetCount) out[(asset + 1) * stride] = radius * sin(TWO_PI * u2);
+        }
+    }
+}
+}
+
+MonteCarloRisk::MonteCarloRisk(const MonteCarloConfig& config) : config(config) {}
+
+void MonteCarloRisk::setVolatility(const string& asset, double annualVolatility) {
+    volatilities[asset] = max(annualVolatility, 0.0);
+}
+
+void MonteCarloRisk::setCorrelation(const string& first, const string& second, double correlation) {
+    if (first == second) return;
+    correlations[minmax(first, second)] = clamp(correlation, -1.0, 1.0);
+}
+
+double MonteCarloRisk::volatilityOf(const string& asset) const {
+    auto it{volatilities.find(asset)};
+    return it != volatilities.end() ? it->second : config.defaultVolatility;
+}
+
+double MonteCarloRisk::correlationOf(const string& first, const string& second) const {
+    if (first == second) return 1.0;
+    auto it{correlations.find(minmax(first, second))};
+    return it != correlations.end() ? it->second : 0.0;
+}
+
+bool MonteCarloRisk::cholesky(const vector<string>& assets, vector<double>& lower) const {
+    size_t n{assets.size()};
+    lower.assign(n * n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j <= i; ++j) {
+            double value{correlationOf(assets[i], assets[j])};
+            for (size_t k = 0; k < j; ++k) value -= lower[i * n + k] * lower[j * n + k];
+            if (i == j) {
+                if (value <= 1e-12) {
+                    cerr << "Correlation matrix is not positive definite at " << assets[i] << endl;
+                    return false;
+                }
+                lower[i * n + i] = sqrt(value);
+            } else {
+                lower[i * n + j] = value / lower[j * n + j];
+            }
+        }
+    }
+    return true;
+}
+
+RiskEstimate MonteCarloRisk::evaluate(const Portfolio& portfolio,
+                                      const map<string, OrderBookStatistics>& statistics) const {
+    vector<string> assets;
+    vector<double> quantities, prices;
+    collectPositions(portfolio, statistics, assets, quantities, prices);
+    return evaluate(assets, quantities, prices);
+}
+
+void MonteCarloRisk::collectPositions(const Portfolio& portfolio, const map<string, OrderBookStatistics>& statistics,
+                                      vector<string>& assets, vector<double>& quantities,
+                                      vector<double>& prices) {
+    assets.clear();
+    quantities.clear();
+    prices.clear();
+    for (const auto& [asset, stats] : statistics) {
+        double quantity{portfolio.getQuantity(asset)};
+        if (quantity == 0.0) continue;
+        double price{stats.midPrice > 0.0 ? stats.midPrice
+                     : stats.lastTradePrice > 0.0 ? stats.lastTradePrice
+                     : max(stats.bidPrice, stats.askPrice)};
+        assets.push_back(asset);
+        quantities.push_back(quantity);
+        prices.push_back(price);
+    }
+}
+
+RiskEstimate MonteCarloRisk::evaluate(const vector<string>& assets, const vector<double>& quantities,
+                                      const vector<double>& prices) const {
+    RiskEstimate estimate;
+    if (assets.size() != quantities.size() || assets.size() != prices.size()) {
+        cerr << "Risk inputs differ in size" << endl;
+        return estimate;
+    }
+
+    vector<string> names;
+    vector<double> values, drifts, scales;
+    double horizon{max(config.horizonDays, 0.0) / TRADING_DAYS};
+    for (size_t i = 0; i < assets.size(); ++i) {
+        if (quantities[i] == 0.0 || !(prices[i] > 0.0)) continue;
+        double sigma{volatilityOf(assets[i])};
+        names.push_back(assets[i]);
+        values.push_back(quantities[i] * prices[i]);
+        drifts.push_back(-0.5 * sigma * sigma * horizon);
+        scales.push_back(sigma * sqrt(horizon));
+        estimate.exposure += fabs(values.back());
+    }
+    if (names.empty() || config.scenarios == 0) return estimate;
+
+    vector<double> lower;
+    if (!cholesky(names, lower)) return estimate;
+
+    auto start{chrono::steady_clock::now()};
+    size_t n{names.size()};
+    size_t scenarios{config.scenarios};
+    size_t blocks{(scenarios + BLOCK - 1) / BLOCK};
+    unsigned threadCount{config.threads > 0 ? config.threads : max(thread::hardware_concurrency(), 1u)};
+    threadCount = static_cast<unsigned>(min<size_t>(threadCount, blocks));
+    Philox rng{{static_cast<uint32_t>(config.seed), static_cast<uint32_t>(config.seed >> 32)}};
+    vector<double> losses(scenarios);
+
+    // Each block is laid out by asset: normals[asset * BLOCK + lane].
+    auto revalue{[&](size_t firstBlock, size_t lastBlock) {
+        vector<double> normals(n * BLOCK), correlated(BLOCK), returns(BLOCK), loss(BLOCK);
+        for (size_t block = firstBlock; block < lastBlock; ++block) {
+            size_t first{block * BLOCK};
+            size_t count{min(BLOCK, scenarios - first)};
+            for (size_t lane = 0; lane < BLOCK; ++lane) drawNormals(rng, first + lane, n, &normals[lane], BLOCK);
+
+            fill(loss.begin(), loss.end(), 0.0);
+            for (size_t i = 0; i < n; ++i) {
+                fill(correlated.begin(), correlated.end(), 0.0);
+                for (size_t j = 0; j <= i; ++j) {
+                    multiplyAdd(correlated.data(), &normals[j * BLOCK], lower[i * n + j], BLOCK);
+                }
+                for (size_t lane = 0; lane < BLOCK; ++lane) {
+                    returns[lane] = expm1(drifts[i] + scales[i] * correlated[lane]);
+                }
+                multiplyAdd(loss.data(), returns.data(), -values[i], BLOCK);
+            }
+            copy(loss.begin(), loss.begin() + count, losses.begin() + first);
+        }
+    }};
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threadCount; ++t) {
+        workers.emplace_back(revalue, blocks * t / threadCount, blocks * (t + 1) / threadCount);
+    }
+    revalue(0, blocks / threadCount);
+    for (auto& worker : workers) worker.join();
+
+    estimate.meanPnL = -sum(losses.data(), scenarios) / scenarios;
+    size_t index{min(scenarios - 1, static_cast<size_t>(clamp(config.confidence, 0.0, 1.0) * scenarios))};
+    nth_element(losses.begin(), losses.begin() + index, losses.end());
+    estimate.valueAtRisk = losses[index];
+    estimate.expectedShortfall = sum(&losses[index], scenarios - index) / (scenarios - index);
+    estimate.scenarios = scenarios;
+    estimate.threads = threadCount;
+    estimate.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    estimate.valid = true;
+    return estimate;
+}
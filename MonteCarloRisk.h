@@ -0,0 +1,79 @@
+#ifndef MONTE_CARLO_RISK_H
+#define MONTE_CARLO_RISK_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "OrderBookManager.h"
+
+class Portfolio;
+
+struct MonteCarloConfig {
+    size_t scenarios{1000000};
+    // Trading days; volatilities are annualized over 252 of them.
+    double horizonDays{1.0};
+    double confidence{0.99};
+    uint64_t seed{1};
+    // 0 uses one thread per hardware thread.
+    unsigned threads{0};
+    double defaultVolatility{0.3};
+};
+
+// Losses are positive numbers: valueAtRisk is the confidence quantile of the horizon loss and
+// expectedShortfall the mean loss at or beyond it. exposure is the gross marked value.
+struct RiskEstimate {
+    double valueAtRisk{0.0};
+    double expectedShortfall{0.0};
+    double meanPnL{0.0};
+    double exposure{0.0};
+    size_t scenarios{0};
+    unsigned threads{0};
+    double seconds{0.0};
+    bool valid{false};
+};
+
+// Full-revaluation Monte Carlo over correlated lognormal returns. Each scenario draws its
+// normals from a Philox counter keyed by the seed and indexed by the scenario number, so a
+// result depends only on the seed and the inputs, never on the thread count or scheduling.
+// Scenarios are revalued in blocks laid out by asset so the correlation and loss sums run
+// over contiguous lanes.
+class MonteCarloRisk {
+public:
+    explicit MonteCarloRisk(const MonteCarloConfig& config = MonteCarloConfig{});
+
+    void setConfig(const MonteCarloConfig& newConfig) { config = newConfig; }
+    const MonteCarloConfig& getConfig() const { return config; }
+    void setVolatility(const std::string& asset, double annualVolatility);
+    // Symmetric; pairs never set are uncorrelated.
+    void setCorrelation(const std::string& first, const std::string& second, double correlation);
+
+    // Positions come from the portfolio for every asset with statistics, marked at the mid
+    // (or the last trade when one side of the book is empty).
+    RiskEstimate evaluate(const Portfolio& portfolio,
+                          const std::map<std::string, OrderBookStatistics>& statistics) const;
+    // The inputs that evaluate takes from the portfolio and statistics, copied out so the
+    // simulation can run after the locks guarding them are released.
+    static void collectPositions(const Portfolio& portfolio,
+                                 const std::map<std::string, OrderBookStatistics>& statistics,
+                                 std::vector<std::string>& assets, std::vector<double>& quantities,
+                                 std::vector<double>& prices);
+    // Invalid when the sizes differ, no position has a price or the correlations are not
+    // positive definite.
+    RiskEstimate evaluate(const std::vector<std::string>& assets, const std::vector<double>& quantities,
+                          const std::vector<double>& prices) const;
+
+private:
+    MonteCarloConfig config;
+    std::map<std::string, double> volatilities;
+    std::map<std::pair<std::string, std::string>, double> correlations;
+
+    double volatilityOf(const std::string& asset) const;
+    double correlationOf(const std::string& first, const std::string& second) const;
+    // Row-major lower-triangular factor of the correlation matrix.
+    bool cholesky(const std::vector<std::string>& assets, std::vector<double>& lower) const;
+};
+
+#endif
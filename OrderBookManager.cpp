@@ -1,7 +1,89 @@
 #include "OrderBookManager.h"
+#include "InputJournal.h"
+#include "OrderMessage.h"
+#include "PerfCounters.h"
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
+namespace {
+// Quantity left on a level after removing an order below which the level counts as empty.
+const double QUANTITY_EPSILON{1e-9};
+
+int64_t toNanos(chrono::system_clock::time_point time) {
+    return chrono::duration_cast<chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// Parsed orders handed from the reader to the matching thread. Orders past count are left
+// over from earlier use and are overwritten in place, so their strings keep their capacity.
+struct OrderChunk {
+    vector<Order> orders;
+    size_t count{0};
+};
+
+// Bounded hand-off: a fixed set of chunks cycles between the free list and the filled queue,
+// so the reader blocks once it is that far ahead of matching.
+class ChunkQueue {
+public:
+    explicit ChunkQueue(size_t chunks) : free(max<size_t>(chunks, 1)) {}
+
+    OrderChunk acquire() {
+        unique_lock<mutex> lock(queueMutex);
+        freeReady.wait(lock, [this] { return !free.empty(); });
+        OrderChunk chunk{move(free.back())};
+        free.pop_back();
+        return chunk;
+    }
+
+    void push(OrderChunk chunk) {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            filled.push_back(move(chunk));
+        }
+        filledReady.notify_one();
+    }
+
+    // False once the reader has closed the queue and every chunk was taken.
+    bool pop(OrderChunk& chunk) {
+        unique_lock<mutex> lock(queueMutex);
+        filledReady.wait(lock, [this] { return !filled.empty() || closed; });
+        if (filled.empty()) return false;
+        chunk = move(filled.front());
+        filled.pop_front();
+        return true;
+    }
+
+    void recycle(OrderChunk chunk) {
+        chunk.count = 0;
+        {
+            lock_guard<mutex> lock(queueMutex);
+            free.push_back(move(chunk));
+        }
+        freeReady.notify_one();
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            closed = true;
+        }
+        filledReady.notify_one();
+    }
+
+private:
+    mutex queueMutex;
+    condition_variable filledReady;
+    condition_variable freeReady;
+    vector<OrderChunk> free;
+    deque<OrderChunk> filled;
+    bool closed{false};
+};
+}
+
 OrderBookManager::OrderBookManager(const string& path) : csvPath(path) {}
 
 chrono::system_clock::time_point OrderBookManager::parseTimestamp(const string& timestamp) {
@@ -11,72 +93,164 @@ chrono::system_clock::time_point OrderBookManager::parseTimestamp(const string&
     return chrono::system_clock::from_time_t(mktime(&tm));
 }
 
+void OrderBookManager::parseOrder(const string& line, Order& order) {
+    stringstream ss(line);
+    string field;
+
+    getline(ss, field, ',');
+    order.id = stoi(field);
+
+    getline(ss, order.asset, ',');
+    getline(ss, order.timestamp, ',');
+    getline(ss, order.type, ',');
+
+    getline(ss, field, ',');
+    order.isShortSell = (field == "True");
+
+    getline(ss, field, ',');
+    order.price = stod(field);
+
+    getline(ss, field, ',');
+    order.quantity = stod(field);
+
+    getline(ss, field, ',');
+    order.totalAmount = stod(field);
+
+    order.dateTime = parseTimestamp(order.timestamp);
+}
+
 void OrderBookManager::loadOrders() {
-    ifstream file(csvPath);
+    PERF_REGION(LoadOrders);
+    ifstream file(csvPath, ios::ate);
+    // Rows are roughly 60 bytes; reserving up front keeps the arena from holding dead growth copies.
+    if (file.is_open()) orders.reserve(orders.size() + static_cast<size_t>(file.tellg()) / 60 + 1);
+    file.seekg(0);
     string line;
     
     getline(file, line);
     
     while (getline(file, line)) {
-        stringstream ss(line);
-        string field;
         Order order;
-        
-        getline(ss, field, ',');
-        order.id = stoi(field);
-        
-        getline(ss, order.asset, ',');
-        getline(ss, order.timestamp, ',');
-        getline(ss, order.type, ',');
-        
-        getline(ss, field, ',');
-        order.isShortSell = (field == "True");
-        
-        getline(ss, field, ',');
-        order.price = stod(field);
-        
-        getline(ss, field, ',');
-        order.quantity = stod(field);
-        
-        getline(ss, field, ',');
-        order.totalAmount = stod(field);
-        
-        order.dateTime = parseTimestamp(order.timestamp);
+        parseOrder(line, order);
         orders.push_back(order);
     }
 }
 
-void OrderBookManager::processOrders() {
-    for (const auto& order : orders) {
-        if (order.type == "BUY") {
-            auto& bidBook{bidBooks[order.asset]};
-            auto it{bidBook.find(order.price)};
-            if (it != bidBook.end()) {
-                it->second.quantity += order.quantity;
-                it->second.id = order.id;
-                it->second.timestamp = order.dateTime;
-            } else {
-                OrderBookEntry entry{order.id, order.price, order.quantity, order.dateTime};
-                bidBook.insert({order.price, entry});
-            }
-        } else {
-            auto& askBook{askBooks[order.asset]};
-            auto it{askBook.find(order.price)};
-            if (it != askBook.end()) {
-                it->second.quantity += order.quantity;
-                it->second.id = order.id;
-                it->second.timestamp = order.dateTime;
-            } else {
-                OrderBookEntry entry{order.id, order.price, order.quantity, order.dateTime};
-                askBook.insert({order.price, entry});
+bool OrderBookManager::streamOrders(size_t chunkOrders, size_t queueChunks) {
+    PERF_REGION(StreamOrders);
+    ifstream file(csvPath);
+    if (!file.is_open()) {
+        cerr << "Cannot open order file " << csvPath << endl;
+        return false;
+    }
+    chunkOrders = max<size_t>(chunkOrders, 1);
+
+    ChunkQueue queue(queueChunks);
+    bool parsed{true};
+    thread reader([&] {
+        string line;
+        getline(file, line);
+        OrderChunk chunk{queue.acquire()};
+        try {
+            while (getline(file, line)) {
+                if (chunk.count == chunk.orders.size()) chunk.orders.emplace_back();
+                parseOrder(line, chunk.orders[chunk.count]);
+                if (++chunk.count == chunkOrders) {
+                    queue.push(move(chunk));
+                    chunk = queue.acquire();
+                }
             }
+        } catch (const exception&) {
+            cerr << "Stopped reading " << csvPath << " at a malformed row: " << line << endl;
+            parsed = false;
+        }
+        if (chunk.count > 0) queue.push(move(chunk));
+        queue.close();
+    });
+
+    // A call auction needs the whole call phase, so it uncrosses once the file is exhausted;
+    // otherwise every chunk is matched as soon as it is in the books.
+    bool auction{uncrossMode == UncrossMode::Auction};
+    int64_t latest{engineClock};
+    bool pending{false};
+    OrderChunk chunk;
+    while (queue.pop(chunk)) {
+        releasingStops = true;
+        for (size_t i = 0; i < chunk.count; ++i) loadOrder(chunk.orders[i], latest);
+        queue.recycle(move(chunk));
+        pending = true;
+        if (!auction) {
+            uncrossBatch(latest);
+            pending = false;
         }
     }
+    reader.join();
+    if (pending) uncrossBatch(latest);
+    return parsed;
+}
+
+void OrderBookManager::loadOrder(const Order& order, int64_t& latest) {
+    if (inputJournal) inputJournal->recordLoadedOrder(order);
+    int64_t timestamp{toNanos(order.dateTime)};
+    latest = max(latest, timestamp);
+    analyticsFor(order.asset).advanceClock(timestamp);
+    bool isBuy{order.type == "BUY"};
+    if (order.orderType == OrderType::Stop || order.orderType == OrderType::StopLimit) {
+        placeStop(order.asset, isBuy, order.id, order.stopPrice, order.price, order.quantity, order.orderType,
+                  order.timeInForce, timestamp, toNanos(order.expireTime));
+        return;
+    }
+    OrderBookEntry& level{isBuy ? rest<BuySide>(order.asset, order.id, order.price, order.quantity, order.dateTime)
+                                : rest<SellSide>(order.asset, order.id, order.price, order.quantity, order.dateTime)};
+    if (order.timeInForce != TimeInForce::GTC) {
+        trackExpiry(order.asset, isBuy, order.id, order.quantity, level, order.timeInForce, timestamp,
+                    toNanos(order.expireTime));
+    }
+}
+
+void OrderBookManager::processOrders() {
+    PERF_REGION(ProcessOrders);
+    int64_t latest{engineClock};
+    // Stops triggered while the batch is loaded or uncrossed are submitted once it is done.
+    releasingStops = true;
+    for (const auto& order : orders) loadOrder(order, latest);
+    uncrossBatch(latest);
+
+    // Queued orders now live in the books; keep them out of the next batch.
+    releaseOrders();
+}
+
+void OrderBookManager::callOrder(const Order& order) {
+    // The first order opens the phase, like the start of a processOrders batch.
+    if (!calling) {
+        calling = true;
+        releasingStops = true;
+        callLatest = engineClock;
+    }
+    loadOrder(order, callLatest);
+}
+
+void OrderBookManager::uncrossCalled() {
+    if (!calling) return;
+    calling = false;
+    uncrossBatch(callLatest);
+}
 
+void OrderBookManager::uncrossBatch(int64_t latest) {
     for (const auto& asset : bidBooks) {
-        auto& bidBook{bidBooks[asset.first]};
-        auto& askBook{askBooks[asset.first]};
+        if (uncrossMode == UncrossMode::Auction) {
+            uncrossAuction(asset.first);
+            continue;
+        }
+
+        auto& bidBook{bidBookFor(asset.first)};
+        auto& askBook{askBookFor(asset.first)};
         auto& stats{statistics[asset.first]};
+        auto& assetAnalytics{analyticsFor(asset.first)};
+        auto& bids{bidDepth[asset.first]};
+        auto& asks{askDepth[asset.first]};
+        double low{0.0};
+        double high{0.0};
 
         while (!bidBook.empty() && !askBook.empty()) {
             auto bid{bidBook.begin()};
@@ -86,31 +260,42 @@ void OrderBookManager::processOrders() {
 
             double execQuantity{min(bid->second.quantity, ask->second.quantity)};
             double execPrice{ask->first};
+            low = (high == 0.0) ? execPrice : min(low, execPrice);
+            high = max(high, execPrice);
 
+            stats.lastTradePrice = execPrice;
             stats.totalTradedQuantity += execQuantity;
             stats.totalTradedAmount += execQuantity * execPrice;
+            assetAnalytics.onTrade(execPrice, execQuantity);
+            bids.add(bid->first, -execQuantity);
+            asks.add(ask->first, -execQuantity);
+            publishExecution(asset.first, Execution{bid->second.id, ask->second.id, execPrice, execQuantity,
+                                                    assetAnalytics.clock()});
             
             if (bid->second.quantity > execQuantity) {
-                OrderBookEntry newEntry{bid->second};
-                newEntry.quantity -= execQuantity;
-                bidBook.erase(bid);
-                bidBook.insert({newEntry.price, newEntry});
+                bid->second.quantity -= execQuantity;
+                bid->second.executedQuantity += execQuantity;
             } else {
                 bidBook.erase(bid);
             }
 
             if (ask->second.quantity > execQuantity) {
-                OrderBookEntry newEntry{ask->second};
-                newEntry.quantity -= execQuantity;
-                askBook.erase(ask);
-                askBook.insert({newEntry.price, newEntry});
+                ask->second.quantity -= execQuantity;
+                ask->second.executedQuantity += execQuantity;
             } else {
                 askBook.erase(ask);
             }
         }
 
         updateStatistics(asset.first);
+        if (high > 0) triggerStops(asset.first, low, high);
     }
+
+    // Expiry is evaluated once the batch is uncrossed, at its latest timestamp.
+    expireOrders(latest);
+    releasingStops = false;
+    releaseStops();
+    if (inputJournal) inputJournal->recordUncross(uncrossMode);
 }
 
 void OrderBookManager::displayOrderBooks() {
@@ -131,16 +316,16 @@ void OrderBookManager::displayOrderBook(const string& asset) {
     cout << string(60, '-') << "\n";
 
     set<double, greater<double>> allPrices;
-    for (const auto& bid : bidBooks[asset]) allPrices.insert(bid.first);
-    for (const auto& ask : askBooks[asset]) allPrices.insert(ask.first);
+    for (const auto& bid : bidBookFor(asset)) allPrices.insert(bid.first);
+    for (const auto& ask : askBookFor(asset)) allPrices.insert(ask.first);
 
     for (double price : allPrices) {
         cout << fixed << setprecision(2);
         
-        auto bid{bidBooks[asset].find(price)};
-        auto ask{askBooks[asset].find(price)};
+        auto bid{bidBookFor(asset).find(price)};
+        auto ask{askBookFor(asset).find(price)};
 
-        if (bid != bidBooks[asset].end()) {
+        if (bid != bidBookFor(asset).end()) {
             cout << setw(15) << left << bid->second.quantity;
         } else {
             cout << setw(15) << " ";
@@ -148,7 +333,7 @@ void OrderBookManager::displayOrderBook(const string& asset) {
         
         cout << setw(15) << right << price;
         
-        if (ask != askBooks[asset].end()) {
+        if (ask != askBookFor(asset).end()) {
             cout << setw(15) << right << ask->second.quantity;
         }
         cout << "\n";
@@ -168,6 +353,14 @@ void OrderBookManager::displayOrderBook(const string& asset) {
     cout << "Ask Depth: " << stats.askDepth << "\n";
     cout << "Total amount Bid side: " << fixed << stats.totalBidAmount << "\n";
     cout << "Total amount Ask side: " << fixed << stats.totalAskAmount << "\n";
+    cout << "Microprice: " << stats.microPrice << "\n";
+    cout << "Order imbalance: " << stats.orderImbalance << "\n";
+    cout << "Rolling VWAP: " << stats.rollingVWAP << "\n";
+    cout << "Realized volatility: " << stats.realizedVolatility << "\n";
+    cout << "Time-weighted spread: " << stats.timeWeightedSpread << "\n";
+    cout << "Trade arrival rate (/s): " << stats.tradeArrivalRate << "\n";
+    cout << "Last trade price: " << stats.lastTradePrice << "\n";
+    cout << "Pending stops: " << getPendingStopCount(asset) << "\n";
 }
 
 void OrderBookManager::saveOrderBooks(const string& outputPath) {
@@ -190,21 +383,21 @@ void OrderBookManager::saveOrderBooks(const string& outputPath) {
         file << "BID VOLUME,PRICE,ASK VOLUME\n";
 
         set<double, greater<double>> allPrices;
-        for (const auto& bid : bidBooks[asset.first]) allPrices.insert(bid.first);
-        for (const auto& ask : askBooks[asset.first]) allPrices.insert(ask.first);
+        for (const auto& bid : bidBookFor(asset.first)) allPrices.insert(bid.first);
+        for (const auto& ask : askBookFor(asset.first)) allPrices.insert(ask.first);
 
         for (double price : allPrices) {
-            auto bid{bidBooks[asset.first].find(price)};
-            auto ask{askBooks[asset.first].find(price)};
+            auto bid{bidBookFor(asset.first).find(price)};
+            auto ask{askBookFor(asset.first).find(price)};
             
-            if (bid != bidBooks[asset.first].end()) {
+            if (bid != bidBookFor(asset.first).end()) {
                 file << bid->second.quantity;
             }
             file << ",";
             
             file << price << ",";
             
-            if (ask != askBooks[asset.first].end()) {
+            if (ask != askBookFor(asset.first).end()) {
                 file << ask->second.quantity;
             }
             file << "\n";
@@ -215,18 +408,20 @@ void OrderBookManager::saveOrderBooks(const string& outputPath) {
 }
 
 void OrderBookManager::updateStatistics(const string& asset) {
+    PERF_REGION(UpdateStatistics);
     auto& stats{statistics[asset]};
-    auto& bidBook{bidBooks[asset]};
-    auto& askBook{askBooks[asset]};
+    auto& bidBook{bidBookFor(asset)};
+    auto& askBook{askBookFor(asset)};
+
+    auto& bids{bidDepth[asset]};
+    auto& asks{askDepth[asset]};
 
     if (!bidBook.empty()) {
         stats.bidPrice = bidBook.begin()->first;
         stats.bidDepth = bidBook.size();
-        stats.totalBidAmount = 0;
-        for (const auto& bid : bidBook) {
-            stats.totalBidAmount += bid.first * bid.second.quantity;
-        }
+        stats.totalBidAmount = bids.totalNotional();
     } else {
+        bids.clear();
         stats.bidPrice = 0.0;
         stats.bidDepth = 0;
         stats.totalBidAmount = 0.0;
@@ -235,11 +430,9 @@ void OrderBookManager::updateStatistics(const string& asset) {
     if (!askBook.empty()) {
         stats.askPrice = askBook.begin()->first;
         stats.askDepth = askBook.size();
-        stats.totalAskAmount = 0;
-        for (const auto& ask : askBook) {
-            stats.totalAskAmount += ask.first * ask.second.quantity;
-        }
+        stats.totalAskAmount = asks.totalNotional();
     } else {
+        asks.clear();
         stats.askPrice = 0.0;
         stats.askDepth = 0;
         stats.totalAskAmount = 0.0;
@@ -253,66 +446,781 @@ void OrderBookManager::updateStatistics(const string& asset) {
         stats.midPrice = (stats.bidPrice + stats.askPrice) / 2;
         stats.bidAskSpread = stats.askPrice - stats.bidPrice;
     }
+
+    auto& assetAnalytics{analyticsFor(asset)};
+    size_t levels{assetAnalytics.getConfig().imbalanceLevels};
+    double topBid{0.0};
+    double topAsk{0.0};
+    size_t n{0};
+    for (auto it{bidBook.begin()}; it != bidBook.end() && n < levels; ++it, ++n) topBid += it->second.quantity;
+    n = 0;
+    for (auto it{askBook.begin()}; it != askBook.end() && n < levels; ++it, ++n) topAsk += it->second.quantity;
+    assetAnalytics.onQuote(stats.bidPrice, bidBook.empty() ? 0.0 : bidBook.begin()->second.quantity,
+                           stats.askPrice, askBook.empty() ? 0.0 : askBook.begin()->second.quantity,
+                           topBid, topAsk);
+
+    const AnalyticsSnapshot& snapshot{assetAnalytics.snapshot()};
+    stats.microPrice = snapshot.microPrice;
+    stats.orderImbalance = snapshot.orderImbalance;
+    stats.rollingVWAP = snapshot.rollingVWAP;
+    stats.realizedVolatility = snapshot.realizedVolatility;
+    stats.timeWeightedSpread = snapshot.timeWeightedSpread;
+    stats.tradeArrivalRate = snapshot.tradeArrivalRate;
+
+    for (const auto& listener : statisticsListeners) {
+        listener(asset, stats);
+    }
 }
 
-void OrderBookManager::processNewOrder(const Order& order) {
-    if (order.type == "BUY") {
-        auto& bidBook{bidBooks[order.asset]};
-        auto it{bidBook.find(order.price)};
-        if (it != bidBook.end()) {
-            it->second.quantity += order.quantity;
-            it->second.id = order.id;
-            it->second.timestamp = order.dateTime;
+void OrderBookManager::seedFrom(const OrderBookManager& other, const string& asset) {
+    auto bid{other.bidBooks.find(asset)};
+    auto ask{other.askBooks.find(asset)};
+    auto stats{other.statistics.find(asset)};
+
+    bidBookFor(asset).clear();
+    askBookFor(asset).clear();
+    if (bid != other.bidBooks.end()) bidBookFor(asset) = bid->second;
+    if (ask != other.askBooks.end()) askBookFor(asset) = ask->second;
+    statistics[asset] = (stats != other.statistics.end()) ? stats->second : OrderBookStatistics{};
+
+    auto otherBidDepth{other.bidDepth.find(asset)};
+    auto otherAskDepth{other.askDepth.find(asset)};
+    bidDepth[asset] = (otherBidDepth != other.bidDepth.end()) ? otherBidDepth->second : DepthIndex{};
+    askDepth[asset] = (otherAskDepth != other.askDepth.end()) ? otherAskDepth->second : DepthIndex{};
+
+    auto otherAnalytics{other.analytics.find(asset)};
+    analytics.erase(asset);
+    if (otherAnalytics != other.analytics.end()) analytics.emplace(asset, otherAnalytics->second);
+
+    auto otherStops{other.stopIndex.find(asset)};
+    StopIndex& stops{stopsFor(asset)};
+    stops.buys.clear();
+    stops.sells.clear();
+    if (otherStops != other.stopIndex.end()) {
+        stops.buys = otherStops->second.buys;
+        stops.sells = otherStops->second.sells;
+    }
+
+    // Copied levels keep their ids, so the other manager's timed orders stay valid here.
+    dropTimedOrders(asset);
+    levelSequence = max(levelSequence, other.levelSequence);
+    for (const auto& [id, order] : other.timedOrders) {
+        if (order.asset != asset) continue;
+        RestingOrder copy{order};
+        copy.timer = expiryWheel.schedule(order.expiry, static_cast<uint32_t>(id));
+        timedOrders[id] = copy;
+    }
+    for (const auto& [trigger, stop] : stops.buys) {
+        if (stop.timeInForce != TimeInForce::GTC) trackStopExpiry(asset, trigger, stop);
+    }
+    for (const auto& [trigger, stop] : stops.sells) {
+        if (stop.timeInForce != TimeInForce::GTC) trackStopExpiry(asset, trigger, stop);
+    }
+}
+
+void OrderBookManager::restoreBook(const string& asset, const vector<OrderBookEntry>& bids,
+                                   const vector<OrderBookEntry>& asks, const OrderBookStatistics& stats,
+                                   const vector<TimedOrder>& timed, const vector<pair<double, StopOrder>>& stops) {
+    auto& bidBook{bidBookFor(asset)};
+    auto& askBook{askBookFor(asset)};
+    bidBook.clear();
+    askBook.clear();
+    for (const auto& entry : bids) {
+        bidBook.emplace_hint(bidBook.end(), entry.price, entry);
+    }
+    for (const auto& entry : asks) {
+        askBook.emplace_hint(askBook.end(), entry.price, entry);
+    }
+    statistics[asset] = stats;
+    analytics.erase(asset);
+    dropTimedOrders(asset);
+    for (const auto& order : timed) {
+        timedOrders[order.id] = RestingOrder{asset, order.isBuy, order.price, order.quantity, order.queuePosition,
+                                             order.levelId, order.expiry,
+                                             expiryWheel.schedule(order.expiry, static_cast<uint32_t>(order.id))};
+    }
+    StopIndex& index{stopsFor(asset)};
+    index.buys.clear();
+    index.sells.clear();
+    for (const auto& [trigger, stop] : stops) {
+        if (stop.isBuy) {
+            index.buys.emplace_hint(index.buys.end(), trigger, stop);
         } else {
-            OrderBookEntry entry{order.id, order.price, order.quantity, order.dateTime};
-            bidBook.insert({order.price, entry});
+            index.sells.emplace_hint(index.sells.end(), trigger, stop);
         }
+        if (stop.timeInForce != TimeInForce::GTC) trackStopExpiry(asset, trigger, stop);
+    }
+    rebuildDepth(bidDepth[asset], bidBook);
+    rebuildDepth(askDepth[asset], askBook);
+}
+
+vector<TimedOrder> OrderBookManager::getTimedOrders(const string& asset) const {
+    vector<TimedOrder> timed;
+    for (const auto& [id, order] : timedOrders) {
+        if (order.asset != asset) continue;
+        timed.push_back(TimedOrder{id, order.isBuy, order.price, order.quantity, order.queuePosition, order.levelId,
+                                   order.expiry});
+    }
+    sort(timed.begin(), timed.end(), [](const TimedOrder& a, const TimedOrder& b) { return a.id < b.id; });
+    return timed;
+}
+
+template <typename Book>
+OrderBookEntry& OrderBookManager::addToLevel(Book& book, int id, double price, double quantity,
+                                             chrono::system_clock::time_point dateTime) {
+    return restAt(book, id, price, quantity, dateTime, levelSequence);
+}
+
+template <typename Book>
+void OrderBookManager::rebuildDepth(DepthIndex& depth, const Book& book) {
+    depth = DepthIndex{};
+    for (const auto& [price, entry] : book) {
+        depth.add(price, entry.quantity);
+    }
+}
+
+FillEstimate OrderBookManager::estimateFill(const string& asset, bool isBuy, double quantity) const {
+    FillEstimate estimate;
+    estimate.requestedQuantity = quantity;
+    const auto& depthMap{isBuy ? askDepth : bidDepth};
+    auto depth{depthMap.find(asset)};
+    auto stats{statistics.find(asset)};
+    if (depth == depthMap.end() || stats == statistics.end() || quantity <= 0) return estimate;
+
+    double notional{0.0};
+    estimate.filledQuantity = isBuy ? depth->second.fillFromLow(quantity, notional, estimate.worstPrice)
+                                    : depth->second.fillFromHigh(quantity, notional, estimate.worstPrice);
+    if (estimate.filledQuantity <= 0) return estimate;
+
+    estimate.averagePrice = notional / estimate.filledQuantity;
+    const auto& s{stats->second};
+    estimate.slippage = isBuy ? estimate.averagePrice - s.askPrice : s.bidPrice - estimate.averagePrice;
+    if (s.midPrice > 0) estimate.impact = fabs(estimate.worstPrice - s.midPrice) / s.midPrice;
+    return estimate;
+}
+
+double OrderBookManager::liquidityUpTo(const string& asset, bool isBuy, double limitPrice) const {
+    if (isBuy) {
+        auto depth{askDepth.find(asset)};
+        return depth != askDepth.end() ? depth->second.quantityAtOrBelow(limitPrice) : 0.0;
+    }
+    auto depth{bidDepth.find(asset)};
+    return depth != bidDepth.end() ? depth->second.quantityAtOrAbove(limitPrice) : 0.0;
+}
+
+void OrderBookManager::releaseOrders() {
+    pmr::vector<Order>(&orderArena).swap(orders);
+    orderArena.release();
+}
+
+pmr::memory_resource* OrderBookManager::memoryFor(const string& asset) {
+    auto& memory{bookMemory[asset]};
+    if (!memory) memory = make_unique<BookMemory>();
+    return &memory->levels;
+}
+
+template <typename Books>
+typename Books::mapped_type& OrderBookManager::bookIn(Books& books, const string& asset) {
+    auto it{books.find(asset)};
+    if (it == books.end()) it = books.try_emplace(asset, memoryFor(asset)).first;
+    return it->second;
+}
+
+const StopIndex* OrderBookManager::getStopIndex(const string& asset) const {
+    auto it{stopIndex.find(asset)};
+    return it != stopIndex.end() ? &it->second : nullptr;
+}
+
+size_t OrderBookManager::getPendingStopCount(const string& asset) const {
+    auto it{stopIndex.find(asset)};
+    return it != stopIndex.end() ? it->second.buys.size() + it->second.sells.size() : 0;
+}
+
+MemoryStats OrderBookManager::getBookMemory(const string& asset) const {
+    auto it{bookMemory.find(asset)};
+    return it != bookMemory.end() ? it->second->levels.stats() : MemoryStats{};
+}
+
+MemoryStats OrderBookManager::getBookReservedMemory(const string& asset) const {
+    auto it{bookMemory.find(asset)};
+    return it != bookMemory.end() ? it->second->reserved.stats() : MemoryStats{};
+}
+
+size_t OrderBookManager::bytesPerLevel() {
+    static const size_t bytes{[] {
+        CountingResource probe;
+        AskBook book{&probe};
+        book.emplace(1.0, OrderBookEntry{});
+        return probe.stats().bytesInUse;
+    }()};
+    return bytes;
+}
+
+void OrderBookManager::displayMemoryUsage() const {
+    cout << "\nMemory usage (" << bytesPerLevel() << " bytes per level)\n";
+    cout << setw(10) << left << "ASSET" << setw(10) << right << "LEVELS" << setw(14) << "IN USE"
+         << setw(14) << "RESERVED" << setw(14) << "PEAK" << setw(14) << "ALLOCS" << "\n";
+    MemoryStats total;
+    for (const auto& [asset, memory] : bookMemory) {
+        MemoryStats levels{memory->levels.stats()};
+        MemoryStats reserved{memory->reserved.stats()};
+        total += reserved;
+        size_t count{0};
+        auto bid{bidBooks.find(asset)};
+        auto ask{askBooks.find(asset)};
+        if (bid != bidBooks.end()) count += bid->second.size();
+        if (ask != askBooks.end()) count += ask->second.size();
+        cout << setw(10) << left << asset << setw(10) << right << count << setw(14) << levels.bytesInUse
+             << setw(14) << reserved.bytesInUse << setw(14) << levels.peakBytes << setw(14) << levels.allocations << "\n";
+    }
+    MemoryStats orderStats{orderMemory.stats()};
+    cout << "Books reserved: " << total.bytesInUse << " bytes (peak " << total.peakBytes << ")\n";
+    cout << "Order arena: " << orderStats.bytesInUse << " bytes in use, " << orderStats.totalBytes
+         << " bytes over " << orderStats.allocations << " chunk allocations\n";
+}
+
+MarketAnalytics& OrderBookManager::analyticsFor(const string& asset) {
+    auto it{analytics.find(asset)};
+    if (it == analytics.end()) {
+        it = analytics.emplace(asset, MarketAnalytics(analyticsConfig)).first;
+    }
+    return it->second;
+}
+
+void OrderBookManager::setAnalyticsConfig(const AnalyticsConfig& config) {
+    analyticsConfig = config;
+    analytics.clear();
+}
+
+const MarketAnalytics* OrderBookManager::getAnalytics(const string& asset) const {
+    auto it{analytics.find(asset)};
+    return it != analytics.end() ? &it->second : nullptr;
+}
+
+void OrderBookManager::restoreAnalytics(const string& asset, const AnalyticsState& state,
+                                        const vector<TradeSample>& trades, const vector<SpreadSample>& spreads) {
+    analyticsFor(asset).restore(state, trades, spreads);
+}
+
+const DepthIndex* OrderBookManager::getDepth(const string& asset, bool bids) const {
+    const auto& depths{bids ? bidDepth : askDepth};
+    auto it{depths.find(asset)};
+    return it != depths.end() ? &it->second : nullptr;
+}
+
+void OrderBookManager::restoreDepth(const string& asset, const DepthIndex& bids, const DepthIndex& asks) {
+    bidDepth[asset] = bids;
+    askDepth[asset] = asks;
+}
+
+void OrderBookManager::addStatisticsListener(StatisticsListener listener) {
+    statisticsListeners.push_back(move(listener));
+}
+
+void OrderBookManager::addExecutionListener(ExecutionListener listener) {
+    executionListeners.push_back(move(listener));
+}
+
+void OrderBookManager::addOrderDoneListener(OrderDoneListener listener) {
+    orderDoneListeners.push_back(move(listener));
+}
+
+void OrderBookManager::orderDone(int id) {
+    for (const auto& listener : orderDoneListeners) {
+        listener(id);
+    }
+}
+
+void OrderBookManager::publishExecution(const string& asset, const Execution& execution) {
+    for (const auto& listener : executionListeners) {
+        listener(asset, execution);
+    }
+}
+
+void OrderBookManager::processNewOrder(const Order& order) {
+    PERF_REGION(ProcessNewOrder);
+    if (inputJournal) inputJournal->recordNewOrder(order);
+    bool isBuy{order.type == "BUY"};
+    double price{order.price};
+    switch (order.orderType) {
+        case OrderType::Stop:
+        case OrderType::StopLimit:
+            placeStop(order.asset, isBuy, order.id, order.stopPrice, order.price, order.quantity, order.orderType,
+                      order.timeInForce, toNanos(order.dateTime), toNanos(order.expireTime));
+            return;
+        case OrderType::Market:
+            if (!marketPrice(order.asset, isBuy, price)) {
+                orderDone(order.id);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    submitOrder(order.asset, isBuy, order.id, price, order.quantity, order.dateTime,
+                order.timeInForce, toNanos(order.expireTime));
+}
+
+void OrderBookManager::submitOrder(const string& asset, bool isBuy, int id, double price, double quantity,
+                                   chrono::system_clock::time_point dateTime, TimeInForce timeInForce,
+                                   int64_t expireTime) {
+    if (isBuy) {
+        match<BuySide>(asset, id, price, quantity, dateTime, timeInForce, expireTime);
     } else {
-        auto& askBook{askBooks[order.asset]};
-        auto it{askBook.find(order.price)};
-        if (it != askBook.end()) {
-            it->second.quantity += order.quantity;
-            it->second.id = order.id;
-            it->second.timestamp = order.dateTime;
-        } else {
-            OrderBookEntry entry{order.id, order.price, order.quantity, order.dateTime};
-            askBook.insert({order.price, entry});
-        }
+        match<SellSide>(asset, id, price, quantity, dateTime, timeInForce, expireTime);
     }
+}
 
-    auto& bidBook{bidBooks[order.asset]};
-    auto& askBook{askBooks[order.asset]};
-    auto& stats{statistics[order.asset]};
+template <typename Side>
+void OrderBookManager::match(const string& asset, int id, double price, double quantity,
+                             chrono::system_clock::time_point dateTime, TimeInForce timeInForce,
+                             int64_t expireTime) {
+    using Opposite = typename Side::Opposite;
+    int64_t timestamp{toNanos(dateTime)};
+    expireOrders(timestamp);
 
-    while (!bidBook.empty() && !askBook.empty()) {
-        auto bid{bidBook.begin()};
-        auto ask{askBook.begin()};
+    auto& ownBook{bookIn(Side::own(bidBooks, askBooks), asset)};
+    auto& book{bookIn(Opposite::own(bidBooks, askBooks), asset)};
+    auto& ownDepth{Side::own(bidDepth, askDepth)[asset]};
+    auto& depth{Opposite::own(bidDepth, askDepth)[asset]};
+    auto& stats{statistics[asset]};
+    auto& assetAnalytics{analyticsFor(asset)};
+    assetAnalytics.advanceClock(timestamp);
+    double low{0.0};
+    double high{0.0};
+    // Depth takes the whole order and then each of its fills, the same floating-point steps as
+    // when orders joined the book before matching, so recorded sessions replay to their digest.
+    ownDepth.add(price, quantity);
 
-        if (bid->first < ask->first) break;
+    // The book was uncrossed before this order arrived, so only the order itself can trade,
+    // against the opposite side at the resting prices; what is left of it then rests.
+    double remaining{sweep<Side>(book, price, quantity, [&](double execPrice, double execQuantity, int restingId) {
+        low = (high == 0.0) ? execPrice : min(low, execPrice);
+        high = max(high, execPrice);
 
-        double execQuantity{min(bid->second.quantity, ask->second.quantity)};
-        double execPrice{ask->first};
-        
+        stats.lastTradePrice = execPrice;
         stats.totalTradedQuantity += execQuantity;
         stats.totalTradedAmount += execPrice * execQuantity;
+        assetAnalytics.onTrade(execPrice, execQuantity);
+        ownDepth.add(price, -execQuantity);
+        depth.add(execPrice, -execQuantity);
+        publishExecution(asset, Execution{Side::IS_BUY ? id : restingId, Side::IS_BUY ? restingId : id, execPrice,
+                                          execQuantity, assetAnalytics.clock()});
+    })};
+
+    if (remaining > 0) {
+        OrderBookEntry& level{addToLevel(ownBook, id, price, remaining, dateTime)};
+        if (timeInForce != TimeInForce::GTC) {
+            trackExpiry(asset, Side::IS_BUY, id, remaining, level, timeInForce, timestamp, expireTime);
+        }
+    }
+    updateStatistics(asset);
+
+    // Every price this sweep traded at counts, so stops between its first and last trade fire too.
+    if (high > 0) {
+        triggerStops(asset, low, high);
+        releaseStops();
+    }
+}
+
+template <typename Side>
+OrderBookEntry& OrderBookManager::rest(const string& asset, int id, double price, double quantity,
+                                       chrono::system_clock::time_point dateTime) {
+    Side::own(bidDepth, askDepth)[asset].add(price, quantity);
+    return addToLevel(bookIn(Side::own(bidBooks, askBooks), asset), id, price, quantity, dateTime);
+}
+
+void OrderBookManager::advanceClock(int64_t nanos) {
+    if (nanos <= engineClock) return;
+    if (inputJournal) inputJournal->recordClock(nanos);
+    expireOrders(nanos);
+}
+
+bool OrderBookManager::cancelOrder(int id) {
+    auto it{timedOrders.find(id)};
+    if (it == timedOrders.end()) return false;
+    if (inputJournal) inputJournal->recordCancel(id);
+
+    expiryWheel.cancel(it->second.timer);
+    string asset{it->second.asset};
+    bool removed{removeResting(it->second) > 0};
+    timedOrders.erase(it);
+    if (removed) updateStatistics(asset);
+    orderDone(id);
+    return removed;
+}
+
+void OrderBookManager::expireOrders(int64_t nanos) {
+    if (nanos <= engineClock) return;
+    engineClock = nanos;
+    expiredIds.clear();
+    expiryWheel.advance(nanos, expiredIds);
+    if (expiredIds.empty()) return;
 
-        if (bid->second.quantity > execQuantity) {
-            OrderBookEntry newEntry{bid->second};
-            newEntry.quantity -= execQuantity;
-            bidBook.erase(bid);
-            bidBook.insert({newEntry.price, newEntry});
+    // Removals from one level depend on their order. The wheel orders timers of one tick by how
+    // they cascaded, which a restored wheel cannot repeat, so they go by expiry, then id.
+    expiredOrders.clear();
+    for (uint64_t id : expiredIds) {
+        auto it{timedOrders.find(static_cast<int>(id))};
+        if (it != timedOrders.end()) {
+            expiredOrders.emplace_back(it->second.expiry, it->first);
         } else {
-            bidBook.erase(bid);
+            expireStop(static_cast<int>(id));
         }
+    }
+    sort(expiredOrders.begin(), expiredOrders.end());
+
+    expiredAssets.clear();
+    for (const auto& [expiry, id] : expiredOrders) {
+        auto it{timedOrders.find(id)};
+        if (removeResting(it->second) > 0 &&
+            find(expiredAssets.begin(), expiredAssets.end(), it->second.asset) == expiredAssets.end()) {
+            expiredAssets.push_back(it->second.asset);
+        }
+        timedOrders.erase(it);
+        orderDone(id);
+    }
+    for (const auto& asset : expiredAssets) {
+        updateStatistics(asset);
+    }
+}
+
+void OrderBookManager::trackExpiry(const string& asset, bool isBuy, int id, double quantity, const OrderBookEntry& level,
+                                   TimeInForce timeInForce, int64_t timestamp, int64_t expireTime) {
+    int64_t expiry{timeInForce == TimeInForce::DAY ? endOfDay(timestamp) : expireTime};
+    auto [it, inserted]{timedOrders.try_emplace(id)};
+    // Ids are expected to be unique among live timed orders; a reused id takes over the entry.
+    if (!inserted) expiryWheel.cancel(it->second.timer);
+    it->second = RestingOrder{asset, isBuy, level.price, quantity, level.queuedQuantity - quantity, level.levelId,
+                              expiry, expiryWheel.schedule(expiry, static_cast<uint32_t>(id))};
+}
+
+double OrderBookManager::removeResting(const RestingOrder& order) {
+    return order.isBuy ? removeFromLevel(bidBookFor(order.asset), bidDepth[order.asset], order)
+                       : removeFromLevel(askBookFor(order.asset), askDepth[order.asset], order);
+}
+
+template <typename Book>
+double OrderBookManager::removeFromLevel(Book& book, DepthIndex& depth, const RestingOrder& order) {
+    auto it{book.find(order.price)};
+    if (it == book.end() || it->second.levelId != order.levelId) return 0.0;
+
+    // Fills reach the queue front first. Removals are counted as leaving from the front too,
+    // which is exact when the oldest order at the level is the one going.
+    OrderBookEntry& level{it->second};
+    double remaining{min(order.quantity, order.queuePosition + order.quantity - level.executedQuantity)};
+    remaining = min(remaining, level.quantity);
+    if (remaining <= 0) return 0.0;
+
+    if (level.quantity - remaining <= QUANTITY_EPSILON) {
+        depth.add(order.price, -level.quantity);
+        book.erase(it);
+    } else {
+        depth.add(order.price, -remaining);
+        level.quantity -= remaining;
+        level.executedQuantity += remaining;
+    }
+    return remaining;
+}
 
-        if (ask->second.quantity > execQuantity) {
-            OrderBookEntry newEntry{ask->second};
-            newEntry.quantity -= execQuantity;
-            askBook.erase(ask);
-            askBook.insert({newEntry.price, newEntry});
+void OrderBookManager::dropTimedOrders(const string& asset) {
+    for (auto it{timedOrders.begin()}; it != timedOrders.end();) {
+        if (it->second.asset == asset) {
+            expiryWheel.cancel(it->second.timer);
+            it = timedOrders.erase(it);
         } else {
-            askBook.erase(ask);
+            ++it;
         }
     }
-    updateStatistics(order.asset);
-}
\ No newline at end of file
+    for (auto it{timedStops.begin()}; it != timedStops.end();) {
+        if (it->second.asset == asset) {
+            expiryWheel.cancel(it->second.timer);
+            it = timedStops.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void OrderBookManager::trackStopExpiry(const string& asset, double triggerPrice, const StopOrder& stop) {
+    int64_t expiry{stop.timeInForce == TimeInForce::DAY ? endOfDay(stop.timestamp) : stop.expireTime};
+    auto [it, inserted]{timedStops.try_emplace(stop.id)};
+    if (!inserted) expiryWheel.cancel(it->second.timer);
+    it->second = TimedStop{asset, stop.isBuy, triggerPrice, expiryWheel.schedule(expiry, static_cast<uint32_t>(stop.id))};
+}
+
+void OrderBookManager::expireStop(int id) {
+    auto it{timedStops.find(id)};
+    if (it == timedStops.end()) return;
+    auto index{stopIndex.find(it->second.asset)};
+    if (index != stopIndex.end()) {
+        auto remove{[id](auto& stops, double trigger) {
+            auto [first, last]{stops.equal_range(trigger)};
+            for (auto stop{first}; stop != last; ++stop) {
+                if (stop->second.id == id) {
+                    stops.erase(stop);
+                    return;
+                }
+            }
+        }};
+        if (it->second.isBuy) {
+            remove(index->second.buys, it->second.triggerPrice);
+        } else {
+            remove(index->second.sells, it->second.triggerPrice);
+        }
+    }
+    timedStops.erase(it);
+    orderDone(id);
+}
+
+int64_t OrderBookManager::endOfDay(int64_t nanos) {
+    if (nanos < dayStart || nanos >= dayEnd) {
+        time_t seconds{static_cast<time_t>(nanos / 1000000000)};
+        tm local{*localtime(&seconds)};
+        local.tm_hour = 0;
+        local.tm_min = 0;
+        local.tm_sec = 0;
+        local.tm_isdst = -1;
+        dayStart = static_cast<int64_t>(mktime(&local)) * 1000000000;
+        local.tm_mday += 1;
+        local.tm_isdst = -1;
+        dayEnd = static_cast<int64_t>(mktime(&local)) * 1000000000;
+    }
+    return dayEnd;
+}
+
+StopIndex& OrderBookManager::stopsFor(const string& asset) {
+    auto it{stopIndex.find(asset)};
+    if (it == stopIndex.end()) it = stopIndex.try_emplace(asset, memoryFor(asset)).first;
+    return it->second;
+}
+
+bool OrderBookManager::marketPrice(const string& asset, bool isBuy, double& price) {
+    // Marketable against the whole opposite side; the rest rests at its far end.
+    if (isBuy) {
+        auto& askBook{askBookFor(asset)};
+        if (askBook.empty()) return false;
+        price = askBook.rbegin()->first;
+    } else {
+        auto& bidBook{bidBookFor(asset)};
+        if (bidBook.empty()) return false;
+        price = bidBook.rbegin()->first;
+    }
+    return true;
+}
+
+void OrderBookManager::placeStop(const string& asset, bool isBuy, int id, double triggerPrice, double limitPrice,
+                                 double quantity, OrderType type, TimeInForce timeInForce, int64_t timestamp,
+                                 int64_t expireTime) {
+    StopIndex& stops{stopsFor(asset)};
+    StopOrder stop{id, isBuy, type, timeInForce, limitPrice, quantity, timestamp, expireTime};
+    if (isBuy) {
+        stops.buys.emplace(triggerPrice, stop);
+    } else {
+        stops.sells.emplace(triggerPrice, stop);
+    }
+    if (timeInForce != TimeInForce::GTC) trackStopExpiry(asset, triggerPrice, stop);
+
+    // Everything else in the index is on the far side of the last trade, so this only
+    // fires the new stop when the market is already through its trigger.
+    double last{statistics[asset].lastTradePrice};
+    if (last > 0) {
+        triggerStops(asset, last, last);
+        releaseStops();
+    }
+}
+
+void OrderBookManager::triggerStops(const string& asset, double low, double high) {
+    auto index{stopIndex.find(asset)};
+    if (index == stopIndex.end()) return;
+    const string& symbol{index->first};
+    StopIndex& stops{index->second};
+
+    auto release{[this, &symbol](const StopOrder& stop) {
+        releasedStops.emplace_back(&symbol, stop);
+        if (stop.timeInForce == TimeInForce::GTC) return;
+        auto timed{timedStops.find(stop.id)};
+        if (timed == timedStops.end()) return;
+        expiryWheel.cancel(timed->second.timer);
+        timedStops.erase(timed);
+    }};
+
+    auto buy{stops.buys.begin()};
+    for (; buy != stops.buys.end() && buy->first <= high; ++buy) release(buy->second);
+    stops.buys.erase(stops.buys.begin(), buy);
+
+    auto sell{stops.sells.begin()};
+    for (; sell != stops.sells.end() && sell->first >= low; ++sell) release(sell->second);
+    stops.sells.erase(stops.sells.begin(), sell);
+}
+
+void OrderBookManager::releaseStops() {
+    // Stops released by the orders submitted here are appended and handled in the same loop,
+    // so a cascade runs iteratively in trigger order.
+    if (releasingStops) return;
+    releasingStops = true;
+    auto now{chrono::system_clock::time_point(
+        chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(engineClock)))};
+    for (size_t i = 0; i < releasedStops.size(); ++i) {
+        const string& asset{*releasedStops[i].first};
+        StopOrder stop{releasedStops[i].second};
+
+        int64_t expiry{stop.timeInForce == TimeInForce::DAY ? endOfDay(stop.timestamp) : stop.expireTime};
+        double price{stop.limitPrice};
+        if ((stop.timeInForce != TimeInForce::GTC && expiry <= engineClock) ||
+            (stop.type == OrderType::Stop && !marketPrice(asset, stop.isBuy, price))) {
+            orderDone(stop.id);
+            continue;
+        }
+        submitOrder(asset, stop.isBuy, stop.id, price, stop.quantity, now, stop.timeInForce, stop.expireTime);
+    }
+    releasedStops.clear();
+    releasingStops = false;
+}
+
+AuctionResult OrderBookManager::indicativeAuction(const string& asset) const {
+    AuctionResult result;
+    auto bidIt{bidBooks.find(asset)};
+    auto askIt{askBooks.find(asset)};
+    if (bidIt == bidBooks.end() || askIt == askBooks.end()) return result;
+    const BidBook& bidBook{bidIt->second};
+    const AskBook& askBook{askIt->second};
+    if (bidBook.empty() || askBook.empty()) return result;
+    double bestBid{bidBook.begin()->first};
+    double bestAsk{askBook.begin()->first};
+    if (bestBid < bestAsk) return result;
+
+    // Only levels in [bestAsk, bestBid] can set the price. Merge them into one ascending curve:
+    // asks walk up from the best ask, bids walk up from the lowest crossed bid.
+    struct CurvePoint {
+        double price;
+        double bidQuantity;
+        double askQuantity;
+    };
+    vector<CurvePoint> curve;
+    auto bid{BidBook::const_reverse_iterator(bidBook.upper_bound(bestAsk))};
+    auto ask{askBook.begin()};
+    auto askEnd{askBook.upper_bound(bestBid)};
+    double totalDemand{0.0};
+    while (bid != bidBook.crend() || ask != askEnd) {
+        if (ask == askEnd || (bid != bidBook.crend() && bid->first < ask->first)) {
+            curve.push_back({bid->first, bid->second.quantity, 0.0});
+            totalDemand += bid->second.quantity;
+            ++bid;
+        } else if (bid == bidBook.crend() || ask->first < bid->first) {
+            curve.push_back({ask->first, 0.0, ask->second.quantity});
+            ++ask;
+        } else {
+            curve.push_back({bid->first, bid->second.quantity, ask->second.quantity});
+            totalDemand += bid->second.quantity;
+            ++bid;
+            ++ask;
+        }
+    }
+
+    // Demand only falls and supply only rises along the curve, so the points with the best
+    // volume and then the smallest surplus form one contiguous run [first, last].
+    double demand{totalDemand};
+    double supply{0.0};
+    double bestVolume{-1.0};
+    double bestSurplus{0.0};
+    size_t first{0};
+    size_t last{0};
+    double firstImbalance{0.0};
+    double lastImbalance{0.0};
+    for (size_t i = 0; i < curve.size(); ++i) {
+        supply += curve[i].askQuantity;
+        double volume{min(demand, supply)};
+        double surplus{fabs(demand - supply)};
+        if (volume > bestVolume + QUANTITY_EPSILON ||
+            (volume > bestVolume - QUANTITY_EPSILON && surplus < bestSurplus - QUANTITY_EPSILON)) {
+            bestVolume = volume;
+            bestSurplus = surplus;
+            first = last = i;
+            firstImbalance = lastImbalance = demand - supply;
+        } else if (volume > bestVolume - QUANTITY_EPSILON && surplus < bestSurplus + QUANTITY_EPSILON) {
+            last = i;
+            lastImbalance = demand - supply;
+        }
+        demand -= curve[i].bidQuantity;
+    }
+
+    double low{curve[first].price};
+    double high{curve[last].price};
+    if (lastImbalance > QUANTITY_EPSILON) {
+        result.price = high;
+    } else if (firstImbalance < -QUANTITY_EPSILON) {
+        result.price = low;
+    } else {
+        auto stats{statistics.find(asset)};
+        double reference{stats != statistics.end() ? stats->second.lastTradePrice : 0.0};
+        result.price = reference > 0 ? min(max(reference, low), high) : (low + high) / 2;
+    }
+
+    double demandAtPrice{0.0};
+    double supplyAtPrice{0.0};
+    for (const auto& point : curve) {
+        if (point.price >= result.price) demandAtPrice += point.bidQuantity;
+        if (point.price <= result.price) supplyAtPrice += point.askQuantity;
+    }
+    result.volume = bestVolume;
+    result.imbalance = demandAtPrice - supplyAtPrice;
+    return result;
+}
+
+AuctionResult OrderBookManager::runAuction(const string& asset) {
+    if (inputJournal) inputJournal->recordAuction(asset);
+    AuctionResult result{uncrossAuction(asset)};
+    releaseStops();
+    return result;
+}
+
+AuctionResult OrderBookManager::uncrossAuction(const string& asset) {
+    AuctionResult result{indicativeAuction(asset)};
+    if (result.volume <= QUANTITY_EPSILON) {
+        updateStatistics(asset);
+        return result;
+    }
+
+    auto& bidBook{bidBookFor(asset)};
+    auto& askBook{askBookFor(asset)};
+    auto& stats{statistics[asset]};
+    auto& assetAnalytics{analyticsFor(asset)};
+    auto& bids{bidDepth[asset]};
+    auto& asks{askDepth[asset]};
+
+    // Both sides fill in price priority at the clearing price. Filled levels are skipped
+    // over and removed in one range erase per side afterwards.
+    double remaining{result.volume};
+    auto bid{bidBook.begin()};
+    auto ask{askBook.begin()};
+    while (bid != bidBook.end() && ask != askBook.end() && remaining > QUANTITY_EPSILON) {
+        double execQuantity{min(min(bid->second.quantity, ask->second.quantity), remaining)};
+        bids.add(bid->first, -execQuantity);
+        asks.add(ask->first, -execQuantity);
+        assetAnalytics.onTrade(result.price, execQuantity);
+        publishExecution(asset, Execution{bid->second.id, ask->second.id, result.price, execQuantity,
+                                          assetAnalytics.clock()});
+        result.executions++;
+
+        bid->second.quantity -= execQuantity;
+        bid->second.executedQuantity += execQuantity;
+        ask->second.quantity -= execQuantity;
+        ask->second.executedQuantity += execQuantity;
+        remaining -= execQuantity;
+        if (bid->second.quantity <= QUANTITY_EPSILON) ++bid;
+        if (ask->second.quantity <= QUANTITY_EPSILON) ++ask;
+    }
+    for (auto it{bidBook.begin()}; it != bid; ++it) bids.add(it->first, -it->second.quantity);
+    for (auto it{askBook.begin()}; it != ask; ++it) asks.add(it->first, -it->second.quantity);
+    bidBook.erase(bidBook.begin(), bid);
+    askBook.erase(askBook.begin(), ask);
+
+    double executed{result.volume - remaining};
+    stats.totalTradedQuantity += executed;
+    stats.totalTradedAmount += executed * result.price;
+    stats.lastTradePrice = result.price;
+    updateStatistics(asset);
+    triggerStops(asset, result.price, result.price);
+    return result;
+}
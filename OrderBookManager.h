@@ -10,6 +10,19 @@
 #include <algorithm>
 #include <iomanip>
 #include <chrono>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+
+#include "MarketAnalytics.h"
+#include "DepthIndex.h"
+#include "MatchingKernel.h"
+#include "MemoryStats.h"
+#include "OrderMessage.h"
+#include "TimerWheel.h"
 
 struct Order {
     int id;
@@ -21,13 +34,25 @@ struct Order {
     double quantity;
     double totalAmount;
     std::chrono::system_clock::time_point dateTime;
+    OrderType orderType{OrderType::Limit};
+    // Trigger of Stop and StopLimit orders; a Stop ignores price.
+    double stopPrice{0.0};
+    TimeInForce timeInForce{TimeInForce::GTC};
+    // Only read for GTT orders.
+    std::chrono::system_clock::time_point expireTime{};
 };
 
+// levelId changes whenever a level is created again, so a tracked order never touches a newer
+// level at its price. queuedQuantity is everything that ever joined the level and
+// executedQuantity everything that left it from the front of the queue.
 struct OrderBookEntry {
     int id;
     double price;
     double quantity;
     std::chrono::system_clock::time_point timestamp;
+    uint64_t levelId{0};
+    double queuedQuantity{0.0};
+    double executedQuantity{0.0};
 };
 
 struct OrderBookStatistics {
@@ -42,28 +67,320 @@ struct OrderBookStatistics {
     int askDepth{0};
     double totalBidAmount{0.0};
     double totalAskAmount{0.0};
+    double microPrice{0.0};
+    double orderImbalance{0.0};
+    double rollingVWAP{0.0};
+    double realizedVolatility{0.0};
+    double timeWeightedSpread{0.0};
+    double tradeArrivalRate{0.0};
+    double lastTradePrice{0.0};
+};
+
+// One match between the best bid and best ask; timestamp is event time in nanoseconds.
+struct Execution {
+    int buyOrderId;
+    int sellOrderId;
+    double price;
+    double quantity;
+    int64_t timestamp;
+};
+
+// Cost of sweeping the opposite side for a given quantity, from the depth index.
+// slippage is the per-unit price paid beyond the touch; impact is the distance from
+// the mid to the worst level reached, relative to the mid.
+struct FillEstimate {
+    double requestedQuantity{0.0};
+    double filledQuantity{0.0};
+    double averagePrice{0.0};
+    double worstPrice{0.0};
+    double slippage{0.0};
+    double impact{0.0};
+};
+
+// An order with an expiry as its book tracks it, for saving and restoring. Levels aggregate
+// orders, so it keeps the level it joined and its place in that level's queue.
+struct TimedOrder {
+    int id;
+    bool isBuy;
+    double price;
+    double quantity;
+    double queuePosition;
+    uint64_t levelId;
+    int64_t expiry;
+};
+
+// A stop waiting in its asset's trigger index. The Stop/StopLimit distinction and the limit
+// only matter once it is released.
+struct StopOrder {
+    int id;
+    bool isBuy;
+    OrderType type;
+    TimeInForce timeInForce;
+    double limitPrice;
+    double quantity;
+    int64_t timestamp;
+    int64_t expireTime;
+};
+
+// Buy stops ascending and sell stops descending by trigger, so whatever a trade triggers is
+// a prefix of one side: O(log n) to place, O(triggered) to release.
+using BuyStops = std::pmr::multimap<double, StopOrder>;
+using SellStops = std::pmr::multimap<double, StopOrder, std::greater<>>;
+
+struct StopIndex {
+    BuyStops buys;
+    SellStops sells;
+
+    explicit StopIndex(std::pmr::memory_resource* memory) : buys(memory), sells(memory) {}
+};
+
+// How processOrders uncrosses a loaded batch: level by level at the ask, or as a call auction
+// at one clearing price.
+enum class UncrossMode : uint8_t {
+    Continuous = 0,
+    Auction = 1
 };
 
+// Clearing price, matched volume and demand minus supply at that price; price stays zero
+// when the book is not crossed.
+struct AuctionResult {
+    double price{0.0};
+    double volume{0.0};
+    double imbalance{0.0};
+    size_t executions{0};
+};
+
+class InputJournal;
+
+// Books allocate their levels from the owning manager's per-asset pool (see BookMemory).
+using BidBook = std::pmr::map<double, OrderBookEntry, BuySide::Compare>;
+using AskBook = std::pmr::map<double, OrderBookEntry, SellSide::Compare>;
+using StatisticsListener = std::function<void(const std::string&, const OrderBookStatistics&)>;
+using ExecutionListener = std::function<void(const std::string&, const Execution&)>;
+using OrderDoneListener = std::function<void(int)>;
+
 class OrderBookManager {
 private:
     std::string csvPath;
-    std::vector<Order> orders;
-    std::map<std::string, std::map<double, OrderBookEntry, std::greater<>>> bidBooks;
-    std::map<std::string, std::map<double, OrderBookEntry>> askBooks;
+    // Bulk-loaded orders live in a monotonic arena released once processOrders consumes them.
+    CountingResource orderMemory;
+    std::pmr::monotonic_buffer_resource orderArena{&orderMemory};
+    std::pmr::vector<Order> orders{&orderArena};
+    // Declared before the books so every pool outlives the nodes it handed out.
+    std::map<std::string, std::unique_ptr<BookMemory>> bookMemory;
+    std::map<std::string, BidBook> bidBooks;
+    std::map<std::string, AskBook> askBooks;
     std::map<std::string, OrderBookStatistics> statistics;
+    std::atomic<int> nextOrderId{1};
+    std::vector<StatisticsListener> statisticsListeners;
+    std::vector<ExecutionListener> executionListeners;
+    std::vector<OrderDoneListener> orderDoneListeners;
+    InputJournal* inputJournal{nullptr};
+    AnalyticsConfig analyticsConfig;
+    std::map<std::string, MarketAnalytics> analytics;
+    std::map<std::string, DepthIndex> bidDepth;
+    std::map<std::string, DepthIndex> askDepth;
 
-    std::chrono::system_clock::time_point parseTimestamp(const std::string& timestamp);
+    // Levels aggregate orders, so an order with an expiry remembers where it joined its level's
+    // queue; its remaining quantity is what the fills since then have not reached.
+    struct RestingOrder {
+        std::string asset;
+        bool isBuy;
+        double price;
+        double quantity;
+        double queuePosition;
+        uint64_t levelId;
+        int64_t expiry;
+        TimerHandle timer;
+    };
+    TimerWheel expiryWheel;
+    std::unordered_map<int, RestingOrder> timedOrders;
+    // DAY and GTT stops share the wheel, so one that never triggers still leaves its index.
+    struct TimedStop {
+        std::string asset;
+        bool isBuy;
+        double triggerPrice;
+        TimerHandle timer;
+    };
+    std::unordered_map<int, TimedStop> timedStops;
+    std::vector<uint64_t> expiredIds;
+    std::vector<std::pair<int64_t, int>> expiredOrders;
+    std::vector<std::string> expiredAssets;
+    uint64_t levelSequence{0};
+    int64_t engineClock{0};
+    int64_t dayStart{0};
+    int64_t dayEnd{0};
+
+    std::map<std::string, StopIndex> stopIndex;
+    // Triggered stops waiting to be submitted, oldest first; drained by releaseStops.
+    std::vector<std::pair<const std::string*, StopOrder>> releasedStops;
+    bool releasingStops{false};
+    UncrossMode uncrossMode{UncrossMode::Continuous};
+    std::mutex engineMutex;
+    bool calling{false};
+    int64_t callLatest{0};
+
+    static std::chrono::system_clock::time_point parseTimestamp(const std::string& timestamp);
+    void loadOrder(const Order& order, int64_t& latest);
+    void uncrossBatch(int64_t latest);
     void updateStatistics(const std::string& asset);
+    MarketAnalytics& analyticsFor(const std::string& asset);
+    std::pmr::memory_resource* memoryFor(const std::string& asset);
+    BidBook& bidBookFor(const std::string& asset) { return bookIn(bidBooks, asset); }
+    AskBook& askBookFor(const std::string& asset) { return bookIn(askBooks, asset); }
+    template <typename Books>
+    typename Books::mapped_type& bookIn(Books& books, const std::string& asset);
+    void releaseOrders();
+    // Picks the side once and runs the matching kernel for it.
+    void submitOrder(const std::string& asset, bool isBuy, int id, double price, double quantity,
+                     std::chrono::system_clock::time_point dateTime, TimeInForce timeInForce, int64_t expireTime);
+    template <typename Side>
+    void match(const std::string& asset, int id, double price, double quantity,
+               std::chrono::system_clock::time_point dateTime, TimeInForce timeInForce, int64_t expireTime);
+    // Adds quantity to the side's level at price, creating it when needed.
+    template <typename Side>
+    OrderBookEntry& rest(const std::string& asset, int id, double price, double quantity,
+                         std::chrono::system_clock::time_point dateTime);
+    template <typename Book>
+    void rebuildDepth(DepthIndex& depth, const Book& book);
+    template <typename Book>
+    OrderBookEntry& addToLevel(Book& book, int id, double price, double quantity,
+                               std::chrono::system_clock::time_point dateTime);
+    template <typename Book>
+    double removeFromLevel(Book& book, DepthIndex& depth, const RestingOrder& order);
+    void trackExpiry(const std::string& asset, bool isBuy, int id, double quantity, const OrderBookEntry& level,
+                     TimeInForce timeInForce, int64_t timestamp, int64_t expireTime);
+    double removeResting(const RestingOrder& order);
+    void expireOrders(int64_t nanos);
+    void dropTimedOrders(const std::string& asset);
+    void trackStopExpiry(const std::string& asset, double triggerPrice, const StopOrder& stop);
+    void expireStop(int id);
+    void orderDone(int id);
+    int64_t endOfDay(int64_t nanos);
+    StopIndex& stopsFor(const std::string& asset);
+    bool marketPrice(const std::string& asset, bool isBuy, double& price);
+    void placeStop(const std::string& asset, bool isBuy, int id, double triggerPrice, double limitPrice,
+                   double quantity, OrderType type, TimeInForce timeInForce, int64_t timestamp, int64_t expireTime);
+    void triggerStops(const std::string& asset, double low, double high);
+    void releaseStops();
+    AuctionResult uncrossAuction(const std::string& asset);
 
 public:
     OrderBookManager(const std::string& path);
     void loadOrders();
+    // Reads the order file on a second thread in chunks of chunkOrders rows, at most queueChunks
+    // of them in flight, and loads each chunk as it arrives; no order vector is kept, so memory
+    // stays flat whatever the file size. In Continuous mode every chunk is uncrossed as its own
+    // batch, in Auction mode the whole file is one call. False when the file cannot be opened
+    // or a row is malformed (rows before it are still processed).
+    bool streamOrders(size_t chunkOrders = 4096, size_t queueChunks = 4);
+    void queueOrder(const Order& order) { orders.push_back(order); }
     void processOrders();
+    // A call phase fed one order at a time: callOrder puts the order in its book without
+    // matching, and uncrossCalled matches everything called since the last one in the current
+    // UncrossMode, as processOrders does for a queued batch.
+    void callOrder(const Order& order);
+    void uncrossCalled();
+    // One row of the order file (id,asset,timestamp,side,short,price,quantity,amount); throws
+    // on a malformed row.
+    static void parseOrder(const std::string& line, Order& order);
     void displayOrderBooks();
     void displayOrderBook(const std::string& asset);
     void saveOrderBooks(const std::string& outputPath);
     void processNewOrder(const Order& order);
+    // Hot-path entry: no string compares or copies. Market orders take the far end of the
+    // opposite side as their limit and are dropped when that side is empty. Instrument sets a
+    // build-time tick and lot (see FixedInstrument); defined in OrderBookManager.ipp.
+    template <typename Instrument = AnyInstrument>
+    void processNewOrder(const OrderMessage& message);
+    // Moves the engine clock forward (it also follows order timestamps) and removes every DAY
+    // and GTT order that expired by then, updating each touched asset's statistics once.
+    void advanceClock(int64_t nanos);
+    int64_t getClock() const { return engineClock; }
+    // Only orders with an expiry are tracked individually; false for any other id or when
+    // nothing of the order is left in the book.
+    bool cancelOrder(int id);
+    size_t getTimedOrderCount() const { return timedOrders.size(); }
+    size_t getPendingStopCount(const std::string& asset) const;
+
+    // Opening and closing auctions: orders queued during the call phase are uncrossed by
+    // processOrders in Auction mode, or a crossed book by runAuction. The price maximizes the
+    // executed volume, then minimizes the surplus, then follows the side of the surplus, and
+    // finally sits nearest the last trade price. Every fill is at that one price.
+    void setUncrossMode(UncrossMode mode) { uncrossMode = mode; }
+    UncrossMode getUncrossMode() const { return uncrossMode; }
+    AuctionResult indicativeAuction(const std::string& asset) const;
+    AuctionResult runAuction(const std::string& asset);
     const std::map<std::string, OrderBookStatistics>& getStatistics() const { return statistics; }
+    void addStatisticsListener(StatisticsListener listener);
+    void addExecutionListener(ExecutionListener listener);
+    // Called with the id of an order the engine stops tracking before all of it traded: a DAY or
+    // GTT order or stop that expired, a cancelled order, and a market order or stop dropped
+    // because the opposite side was empty. Fully filled orders are not reported.
+    void addOrderDoneListener(OrderDoneListener listener);
+    // Hands an execution to the execution listeners; for trades made elsewhere (a shard) that
+    // this manager's listeners should see.
+    void publishExecution(const std::string& asset, const Execution& execution);
+    // The engine itself takes no locks. Threads sharing a manager (simulator, console, gateway)
+    // hold this around every call that changes it and around walks of its books and statistics;
+    // listeners run under it.
+    std::mutex& getEngineMutex() { return engineMutex; }
+    void attachInputJournal(InputJournal* journal) { inputJournal = journal; }
+    InputJournal* getInputJournal() const { return inputJournal; }
+    // Applies to every asset; running windows restart from the next event.
+    void setAnalyticsConfig(const AnalyticsConfig& config);
+    const AnalyticsConfig& getAnalyticsConfig() const { return analyticsConfig; }
+    // Null until the asset's first event. restoreAnalytics puts back a saved state after
+    // restoreBook, which drops the asset's analytics.
+    const MarketAnalytics* getAnalytics(const std::string& asset) const;
+    void restoreAnalytics(const std::string& asset, const AnalyticsState& state,
+                          const std::vector<TradeSample>& trades, const std::vector<SpreadSample>& spreads);
+    // Null until the asset's first order. restoreDepth puts back saved indexes after restoreBook,
+    // which sums them again from the levels.
+    const DepthIndex* getDepth(const std::string& asset, bool bids) const;
+    void restoreDepth(const std::string& asset, const DepthIndex& bids, const DepthIndex& asks);
+    void seedFrom(const OrderBookManager& other, const std::string& asset);
+    const std::map<std::string, BidBook>& getBidBooks() const { return bidBooks; }
+    const std::map<std::string, AskBook>& getAskBooks() const { return askBooks; }
+
+    // O(log levels) depth queries. A buy sweeps asks upward, a sell sweeps bids downward;
+    // liquidityUpTo is the opposite-side quantity an order limited at limitPrice could reach.
+    FillEstimate estimateFill(const std::string& asset, bool isBuy, double quantity) const;
+    double liquidityUpTo(const std::string& asset, bool isBuy, double limitPrice) const;
+
+    // Bulk rebuild of one asset from levels already in book order (bids descending, asks ascending).
+    // The timed orders replace the asset's and are scheduled again; their levels must keep the
+    // ids, queued and executed quantities they had when saved. The stops (trigger, stop) replace
+    // its stop index and go in the order given, which is kept among equal triggers.
+    void restoreBook(const std::string& asset, const std::vector<OrderBookEntry>& bids,
+                     const std::vector<OrderBookEntry>& asks, const OrderBookStatistics& stats,
+                     const std::vector<TimedOrder>& timed = {},
+                     const std::vector<std::pair<double, StopOrder>>& stops = {});
+    // The asset's timed orders by id.
+    std::vector<TimedOrder> getTimedOrders(const std::string& asset) const;
+    // Null when the asset never had a stop.
+    const StopIndex* getStopIndex(const std::string& asset) const;
+    // Ids given to new levels continue after the sequence, so a restore sets it back.
+    uint64_t getLevelSequence() const { return levelSequence; }
+    void setLevelSequence(uint64_t sequence) { levelSequence = sequence; }
+    // Sets the engine clock without expiring anything; for restores, whose orders were live then.
+    void setClock(int64_t nanos) { engineClock = nanos; }
+
+    // levels: map nodes held by the asset's books and stop index; reserved: chunks its pool took
+    // from the heap.
+    MemoryStats getBookMemory(const std::string& asset) const;
+    MemoryStats getBookReservedMemory(const std::string& asset) const;
+    MemoryStats getOrderMemory() const { return orderMemory.stats(); }
+    void displayMemoryUsage() const;
+    // Bytes one price level costs in a book, measured on this standard library.
+    static size_t bytesPerLevel();
+    static size_t estimateBookBytes(size_t levels) { return levels * bytesPerLevel(); }
+
+    int allocateOrderId() { return nextOrderId.fetch_add(1, std::memory_order_relaxed); }
+    int getNextOrderId() const { return nextOrderId.load(std::memory_order_relaxed); }
+    void setNextOrderId(int id) { nextOrderId.store(id, std::memory_order_relaxed); }
 };
 
+#include "OrderBookManager.ipp"
+
 #endif
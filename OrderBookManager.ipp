@@ -0,0 +1,48 @@
+#ifndef ORDER_BOOK_MANAGER_IPP
+#define ORDER_BOOK_MANAGER_IPP
+
+// Member templates of OrderBookManager that callers instantiate with their own arguments;
+// included at the end of OrderBookManager.h.
+
+#include "InputJournal.h"
+#include "PerfCounters.h"
+
+template <typename Instrument>
+void OrderBookManager::processNewOrder(const OrderMessage& message) {
+    PERF_REGION(ProcessNewOrder);
+    const std::string& asset{assetSymbol(message.assetId)};
+    uint32_t lots{static_cast<uint32_t>(message.quantity / Instrument::LOT * Instrument::LOT)};
+    if (asset.empty() || lots == 0) {
+        orderDone(static_cast<int>(message.orderId));
+        return;
+    }
+
+    bool isBuy{message.side == Side::Buy};
+    double price{ticksToPrice(isBuy ? BuySide::toTick(message.price, Instrument::TICK)
+                                    : SellSide::toTick(message.price, Instrument::TICK))};
+    if (message.type == OrderType::Market && !marketPrice(asset, isBuy, price)) {
+        orderDone(static_cast<int>(message.orderId));
+        return;
+    }
+    bool isStop{message.type == OrderType::Stop || message.type == OrderType::StopLimit};
+    double quantity{lotsToQuantity(lots)};
+    int id{static_cast<int>(message.orderId)};
+    int64_t expireTime{message.timeInForce == TimeInForce::GTT
+                           ? message.timestamp + static_cast<int64_t>(message.expirySeconds) * 1000000000 : 0};
+
+    if (inputJournal) {
+        inputJournal->recordNewOrder(asset, isBuy, id, price, quantity, message.timestamp,
+                                     (message.flags & ORDER_FLAG_SHORT_SELL) != 0, message.timeInForce, expireTime,
+                                     isStop ? message.type : OrderType::Limit, isStop ? price : 0.0);
+    }
+    if (isStop) {
+        placeStop(asset, isBuy, id, price, price, quantity, message.type, message.timeInForce, message.timestamp,
+                  expireTime);
+        return;
+    }
+    submitOrder(asset, isBuy, id, price, quantity, std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(message.timestamp))),
+        message.timeInForce, expireTime);
+}
+
+#endif
@@ -1,4 +1,6 @@
 #include "OrderBookSimulator.h"
+#include "OrderGenerator.h"
+#include "AsyncLogger.h"
 
 using namespace std;
 
@@ -8,6 +10,8 @@ OrderBookSimulator::OrderBookSimulator(OrderBookManager& ob): orderBook(ob) {
     const auto& stats{orderBook.getStatistics()};
     for (const auto& [asset, _] : stats) {
         assets.push_back(asset);
+        int id{getAssetId(asset)};
+        if (id >= 0) assetIds.push_back(static_cast<uint16_t>(id));
     }
     initializeGenerators();
 }
@@ -25,6 +29,7 @@ void OrderBookSimulator::initializeGenerators() {
 Order OrderBookSimulator::generateOrder(const string& asset, double minPrice, 
                                       double maxPrice, double midPrice) {
     Order order;
+    order.id = orderBook.allocateOrderId();
     order.asset = asset;
 
     bool isBuyOrder{buySellDists[asset](generators[asset])};
@@ -61,13 +66,8 @@ Order OrderBookSimulator::generateOrder(const string& asset, double minPrice,
     order.timestamp = ss.str();
     order.dateTime = now;
 
-    cout << "\n==== New order for " << asset << " ====" << endl;
-    cout << "Timestamp: " << order.timestamp << endl;
-    cout << "Type: " << order.type << " (" << orderCategory << ")" << endl;
-    cout << "Price: " << fixed << setprecision(3) << order.price << endl;
-    cout << "Quantity: " << order.quantity << endl;
-    cout << "Total Amount: " << order.totalAmount << endl;
-    cout << "================================" << endl;
+    LOB_LOG(LogLevel::Info, LogFormat::SimulatedOrder, asset, order.type, orderCategory,
+            order.price, order.quantity, order.totalAmount);
 
     return order;
 }
@@ -82,23 +82,32 @@ void OrderBookSimulator::simulateRealtime(int durationSeconds) {
     }
 
     while (running) {
-        const auto& stats{orderBook.getStatistics()};
-        
-        for (const auto& asset : assets) {
-            const auto& assetStats{stats.at(asset)};
-            
-            double minPrice{assetStats.bidPrice};
-            double maxPrice{assetStats.askPrice};
-            double midPrice{assetStats.midPrice};
-
-            if (minPrice <= 0 || maxPrice <= 0 || midPrice <= 0) {
-                continue;
+        unique_lock<mutex> engine(orderBook.getEngineMutex());
+        if (!agentModels.empty()) {
+            simulateTick(TIME_INTERVAL);
+            for (const auto& asset : assets) {
+                orderBook.displayOrderBook(asset);
             }
+        } else {
+            const auto& stats{orderBook.getStatistics()};
 
-            Order newOrder{generateOrder(asset, minPrice, maxPrice, midPrice)};
-            orderBook.processNewOrder(newOrder);
-            orderBook.displayOrderBook(asset);
+            for (const auto& asset : assets) {
+                const auto& assetStats{stats.at(asset)};
+
+                double minPrice{assetStats.bidPrice};
+                double maxPrice{assetStats.askPrice};
+                double midPrice{assetStats.midPrice};
+
+                if (minPrice <= 0 || maxPrice <= 0 || midPrice <= 0) {
+                    continue;
+                }
+
+                Order newOrder{generateOrder(asset, minPrice, maxPrice, midPrice)};
+                orderBook.processNewOrder(newOrder);
+                orderBook.displayOrderBook(asset);
+            }
         }
+        engine.unlock();
         this_thread::sleep_for(chrono::seconds(TIME_INTERVAL));
         if (durationSeconds > 0) {
             auto currentTime{chrono::steady_clock::now()};
@@ -108,4 +117,54 @@ void OrderBookSimulator::simulateRealtime(int durationSeconds) {
             }
         }
     }
+}
+
+void OrderBookSimulator::addAgentModel(unique_ptr<AgentModel> model) {
+    agentModels.push_back(move(model));
+}
+
+void OrderBookSimulator::addDefaultPopulation() {
+    size_t assetCount{assetIds.size()};
+    addAgentModel(make_unique<NoiseTraders>(200, assetCount, 0.01));
+    addAgentModel(make_unique<MarketMakers>(10, assetCount, 0.5, 100.0));
+    addAgentModel(make_unique<MomentumTraders>(50, assetCount, 30.0, 300.0, 0.5, 0.05));
+    addAgentModel(make_unique<HawkesTraders>(assetCount, 0.05, 0.015, 0.05));
+}
+
+size_t OrderBookSimulator::simulateTick(double dt) {
+    const auto& stats{orderBook.getStatistics()};
+    snapshots.resize(assetIds.size());
+    for (size_t i = 0; i < assetIds.size(); ++i) {
+        auto it{stats.find(assetSymbol(assetIds[i]))};
+        snapshots[i] = (it != stats.end())
+            ? MarketSnapshot{it->second.bidPrice, it->second.askPrice, it->second.midPrice}
+            : MarketSnapshot{};
+    }
+
+    batch.clear();
+    for (auto& model : agentModels) {
+        model->generate(assetIds, snapshots, dt, batch);
+    }
+
+    if (clockNanos == 0) {
+        clockNanos = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+    for (auto& message : batch) {
+        message.orderId = static_cast<uint32_t>(orderBook.allocateOrderId());
+        message.timestamp = clockNanos;
+        orderBook.processNewOrder(message);
+    }
+
+    // Expiries due within the tick leave the book even when no order arrives.
+    clockNanos += llround(dt * 1e9);
+    orderBook.advanceClock(clockNanos);
+    return batch.size();
+}
+
+size_t OrderBookSimulator::simulateBatch(int ticks, double dt) {
+    size_t total{0};
+    for (int t = 0; t < ticks; ++t) {
+        total += simulateTick(dt);
+    }
+    return total;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define ORDER_BOOK_SIMULATOR_H
 
 #include "OrderBookManager.h"
+#include "OrderFlowAgents.h"
 #include <random>
 #include <chrono>
 #include <thread>
@@ -10,6 +11,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <memory>
 
 class OrderBookSimulator {
 private:
@@ -19,6 +21,13 @@ private:
     std::map<std::string, std::uniform_real_distribution<>> volumeDists;
     std::map<std::string, std::bernoulli_distribution> marketLimitDists;
     std::map<std::string, std::bernoulli_distribution> buySellDists;
+    std::vector<std::unique_ptr<AgentModel>> agentModels;
+    // Assets known to ASSETS, by id, for the agent path; snapshots line up with them.
+    std::vector<uint16_t> assetIds;
+    std::vector<MarketSnapshot> snapshots;
+    std::vector<OrderMessage> batch;
+    // Simulated time in nanoseconds; starts at the wall clock and moves dt per tick.
+    int64_t clockNanos{0};
 
     Order generateOrder(const std::string& asset, double minPrice, double maxPrice, 
                        double midPrice);
@@ -26,7 +35,17 @@ private:
 
 public:
     OrderBookSimulator(OrderBookManager& ob);
+    // Holds the manager's engine mutex for each tick, not while it sleeps between them.
     void simulateRealtime(int durationSeconds = -1);
+
+    // With agent models registered, each tick is generated in one batch per model.
+    void addAgentModel(std::unique_ptr<AgentModel> model);
+    // Noise traders, market makers, trend followers and a Hawkes burst process over the
+    // simulator's assets, with rates suited to the console run.
+    void addDefaultPopulation();
+    size_t simulateTick(double dt);
+    size_t simulateBatch(int ticks, double dt);
+    const std::vector<std::string>& getAssets() const { return assets; }
 };
 
 #endif
\ No newline at end of file
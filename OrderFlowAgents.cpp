@@ -0,0 +1,194 @@
+#include "OrderFlowAgents.h"
+#include <cmath>
+
+using namespace std;
+
+namespace {
+const double LN2{0.6931471805599453};
+
+double eventProbability(double rate, double dt) {
+    return 1.0 - exp(-rate * dt);
+}
+}
+
+void AgentModel::setTimeInForce(TimeInForce tif, double lifetimeSeconds) {
+    timeInForce = tif;
+    expirySeconds = static_cast<uint16_t>(min(max(llround(lifetimeSeconds), 1LL), 65535LL));
+}
+
+void AgentModel::appendOrder(vector<OrderMessage>& out, uint16_t assetId, bool isBuy,
+                             double price, double quantity) const {
+    uint32_t lots{quantityToLots(quantity)};
+    if (lots == 0) return;
+    out.emplace_back();
+    OrderMessage& message{out.back()};
+    message = OrderMessage{};
+    message.price = priceToTicks(price);
+    message.quantity = lots;
+    message.assetId = assetId;
+    message.side = isBuy ? Side::Buy : Side::Sell;
+    message.type = OrderType::Limit;
+    message.timeInForce = timeInForce;
+    message.expirySeconds = expirySeconds;
+}
+
+NoiseTraders::NoiseTraders(size_t agentCount, size_t, double ordersPerAgentPerSecond,
+                           double stdDev, double marketRatio, uint64_t seed)
+    : arrivalRates(agentCount), maxQuantities(agentCount), totalRate(0.0),
+      priceStdDev(stdDev), marketOrderRatio(marketRatio), rng(seed) {
+    uniform_real_distribution<> rateJitter(0.5, 1.5);
+    uniform_real_distribution<> quantityDist(10.0, 1000.0);
+    for (size_t i = 0; i < agentCount; ++i) {
+        arrivalRates[i] = ordersPerAgentPerSecond * rateJitter(rng);
+        maxQuantities[i] = quantityDist(rng);
+        totalRate += arrivalRates[i];
+    }
+}
+
+void NoiseTraders::generate(const vector<uint16_t>& assetIds, const vector<MarketSnapshot>& market,
+                            double dt, vector<OrderMessage>& out) {
+    if (arrivalRates.empty() || totalRate * dt <= 0) return;
+    poisson_distribution<long> arrivals(totalRate * dt);
+    uniform_int_distribution<size_t> agentDist(0, arrivalRates.size() - 1);
+    uniform_real_distribution<> unit(0.0, 1.0);
+    normal_distribution<> offset(0.0, priceStdDev);
+
+    for (size_t a = 0; a < assetIds.size(); ++a) {
+        const MarketSnapshot& snapshot{market[a]};
+        if (snapshot.midPrice <= 0) continue;
+
+        long count{arrivals(rng)};
+        for (long k = 0; k < count; ++k) {
+            size_t agent{agentDist(rng)};
+            bool isBuy{unit(rng) < 0.5};
+            double quantity{0.1 + unit(rng) * maxQuantities[agent]};
+            double price;
+            if (unit(rng) < marketOrderRatio) {
+                price = isBuy ? snapshot.askPrice : snapshot.bidPrice;
+            } else {
+                price = snapshot.midPrice + offset(rng);
+            }
+            if (price > 0) appendOrder(out, assetIds[a], isBuy, price, quantity);
+        }
+    }
+}
+
+MarketMakers::MarketMakers(size_t agentCount, size_t assetCountIn, double halfSpread, double quoteSize,
+                           double refresh, double skew, uint64_t seed)
+    : agents(agentCount), assetCount(assetCountIn), halfSpreads(agentCount), quoteSizes(agentCount),
+      inventories(agentCount * assetCountIn, 0.0), refreshRate(refresh), inventorySkew(skew), rng(seed) {
+    uniform_real_distribution<> jitter(0.75, 1.25);
+    for (size_t i = 0; i < agentCount; ++i) {
+        halfSpreads[i] = halfSpread * jitter(rng);
+        quoteSizes[i] = quoteSize * jitter(rng);
+    }
+}
+
+void MarketMakers::generate(const vector<uint16_t>& assetIds, const vector<MarketSnapshot>& market,
+                            double dt, vector<OrderMessage>& out) {
+    if (refreshRate <= 0) return;
+    bernoulli_distribution refresh(eventProbability(refreshRate, dt));
+    // A quote lasts past the next tick by one expected refresh interval, so quotes a maker has
+    // replaced expire instead of piling up in the book.
+    setTimeInForce(TimeInForce::GTT, dt + 1.0 / refreshRate);
+    size_t assetsInUse{min(assetIds.size(), assetCount)};
+
+    for (size_t a = 0; a < assetsInUse; ++a) {
+        const MarketSnapshot& snapshot{market[a]};
+        if (snapshot.midPrice <= 0) continue;
+
+        for (size_t i = 0; i < agents; ++i) {
+            if (!refresh(rng)) continue;
+            double& inventory{inventories[i * assetCount + a]};
+            double center{snapshot.midPrice - inventory * inventorySkew};
+            double bid{center - halfSpreads[i]};
+            double ask{center + halfSpreads[i]};
+
+            // Quotes that cross the opposite touch trade on arrival; track them as inventory.
+            if (snapshot.askPrice > 0 && bid >= snapshot.askPrice) inventory += quoteSizes[i];
+            if (snapshot.bidPrice > 0 && ask <= snapshot.bidPrice) inventory -= quoteSizes[i];
+
+            if (bid > 0) appendOrder(out, assetIds[a], true, bid, quoteSizes[i]);
+            appendOrder(out, assetIds[a], false, ask, quoteSizes[i]);
+        }
+    }
+}
+
+MomentumTraders::MomentumTraders(size_t agentCount, size_t assetCount, double fastHL, double slowHL,
+                                 double threshold, double rate, double qty, uint64_t seed)
+    : thresholds(agentCount), fastAverages(assetCount, 0.0), slowAverages(assetCount, 0.0),
+      fastHalfLife(fastHL), slowHalfLife(slowHL), tradeRate(rate), quantity(qty), rng(seed) {
+    uniform_real_distribution<> jitter(0.5, 2.0);
+    for (auto& t : thresholds) {
+        t = threshold * jitter(rng);
+    }
+}
+
+void MomentumTraders::generate(const vector<uint16_t>& assetIds, const vector<MarketSnapshot>& market,
+                               double dt, vector<OrderMessage>& out) {
+    double fastWeight{1.0 - exp(-LN2 * dt / fastHalfLife)};
+    double slowWeight{1.0 - exp(-LN2 * dt / slowHalfLife)};
+    bernoulli_distribution trade(eventProbability(tradeRate, dt));
+    size_t assetsInUse{min(assetIds.size(), fastAverages.size())};
+
+    for (size_t a = 0; a < assetsInUse; ++a) {
+        const MarketSnapshot& snapshot{market[a]};
+        if (snapshot.midPrice <= 0) continue;
+
+        double& fast{fastAverages[a]};
+        double& slow{slowAverages[a]};
+        if (slow <= 0) {
+            fast = slow = snapshot.midPrice;
+            continue;
+        }
+        fast += fastWeight * (snapshot.midPrice - fast);
+        slow += slowWeight * (snapshot.midPrice - slow);
+
+        double signal{(fast - slow) / slow};
+        bool isBuy{signal > 0};
+        double price{isBuy ? snapshot.askPrice : snapshot.bidPrice};
+        if (price <= 0) continue;
+
+        for (double threshold : thresholds) {
+            if (fabs(signal) > threshold && trade(rng)) {
+                appendOrder(out, assetIds[a], isBuy, price, quantity);
+            }
+        }
+    }
+}
+
+HawkesTraders::HawkesTraders(size_t assetCount, double mu, double a, double b, double maxQty, uint64_t seed)
+    : excitations(assetCount, 0.0), baseIntensity(mu), alpha(a), beta(b), maxQuantity(maxQty), rng(seed) {}
+
+void HawkesTraders::generate(const vector<uint16_t>& assetIds, const vector<MarketSnapshot>& market,
+                             double dt, vector<OrderMessage>& out) {
+    double decay{exp(-beta * dt)};
+    uniform_real_distribution<> unit(0.0, 1.0);
+    size_t assetsInUse{min(assetIds.size(), excitations.size())};
+
+    for (size_t a = 0; a < assetsInUse; ++a) {
+        const MarketSnapshot& snapshot{market[a]};
+        double& excitation{excitations[a]};
+        if (snapshot.midPrice <= 0) {
+            excitation *= decay;
+            continue;
+        }
+
+        double expected{(baseIntensity + excitation) * dt};
+        long count{expected > 0 ? poisson_distribution<long>(expected)(rng) : 0};
+        excitation = excitation * decay + alpha * static_cast<double>(count);
+
+        double spread{max(snapshot.askPrice - snapshot.bidPrice, 0.0)};
+        for (long k = 0; k < count; ++k) {
+            bool isBuy{unit(rng) < 0.5};
+            bool aggressive{unit(rng) < 0.5};
+            double price;
+            if (aggressive) {
+                price = isBuy ? snapshot.askPrice : snapshot.bidPrice;
+            } else {
+                price = isBuy ? snapshot.bidPrice + unit(rng) * spread : snapshot.askPrice - unit(rng) * spread;
+            }
+            if (price > 0) appendOrder(out, assetIds[a], isBuy, price, 1.0 + unit(rng) * maxQuantity);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+#ifndef ORDER_FLOW_AGENTS_H
+#define ORDER_FLOW_AGENTS_H
+
+#include "OrderBookManager.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct MarketSnapshot {
+    double bidPrice{0.0};
+    double askPrice{0.0};
+    double midPrice{0.0};
+};
+
+// A population of agents of one type. Per-agent and per-asset state is kept in flat
+// arrays and a whole tick of orders is produced by a single generate() call, so the
+// virtual dispatch cost is paid once per type per tick rather than once per order.
+// Assets are addressed by their index in the simulator's asset list; orders are emitted
+// as OrderMessage with the simulator filling in ids and timestamps.
+class AgentModel {
+public:
+    virtual ~AgentModel() = default;
+    virtual const char* name() const = 0;
+    virtual void generate(const std::vector<uint16_t>& assetIds, const std::vector<MarketSnapshot>& market,
+                          double dt, std::vector<OrderMessage>& out) = 0;
+    // Orders are GTC unless set; GTT orders expire lifetimeSeconds (whole seconds, at least one)
+    // after their timestamp.
+    void setTimeInForce(TimeInForce tif, double lifetimeSeconds = 0.0);
+
+protected:
+    void appendOrder(std::vector<OrderMessage>& out, uint16_t assetId, bool isBuy,
+                     double price, double quantity) const;
+
+private:
+    TimeInForce timeInForce{TimeInForce::GTC};
+    uint16_t expirySeconds{0};
+};
+
+// Uncorrelated Poisson flow: random side, limit prices normal around the mid,
+// a fraction crossing the spread as marketable orders.
+class NoiseTraders : public AgentModel {
+public:
+    NoiseTraders(size_t agentCount, size_t assetCount, double ordersPerAgentPerSecond,
+                 double priceStdDev = 3.0, double marketOrderRatio = 0.2, uint64_t seed = 1);
+    const char* name() const override { return "noise"; }
+    void generate(const std::vector<uint16_t>& assetIds, const std::vector<MarketSnapshot>& market,
+                  double dt, std::vector<OrderMessage>& out) override;
+
+private:
+    std::vector<double> arrivalRates;
+    std::vector<double> maxQuantities;
+    double totalRate;
+    double priceStdDev;
+    double marketOrderRatio;
+    std::mt19937_64 rng;
+};
+
+// Each maker refreshes a two-sided quote around the mid with probability refreshRate
+// per second, skewing its quote against its running inventory estimate. Quotes are GTT
+// whatever setTimeInForce asked for, and expire about one refresh after the next tick.
+class MarketMakers : public AgentModel {
+public:
+    MarketMakers(size_t agentCount, size_t assetCount, double halfSpread, double quoteSize,
+                 double refreshRate = 1.0, double inventorySkew = 0.001, uint64_t seed = 2);
+    const char* name() const override { return "market-maker"; }
+    void generate(const std::vector<uint16_t>& assetIds, const std::vector<MarketSnapshot>& market,
+                  double dt, std::vector<OrderMessage>& out) override;
+
+private:
+    size_t agents;
+    size_t assetCount;
+    std::vector<double> halfSpreads;
+    std::vector<double> quoteSizes;
+    std::vector<double> inventories;
+    double refreshRate;
+    double inventorySkew;
+    std::mt19937_64 rng;
+};
+
+// Trend followers: fast/slow exponential averages of the mid per asset; when their
+// spread exceeds an agent's threshold the agent sends a marketable order with the trend.
+class MomentumTraders : public AgentModel {
+public:
+    MomentumTraders(size_t agentCount, size_t assetCount, double fastHalfLife, double slowHalfLife,
+                    double threshold, double tradeRate = 0.5, double quantity = 100.0, uint64_t seed = 3);
+    const char* name() const override { return "momentum"; }
+    void generate(const std::vector<uint16_t>& assetIds, const std::vector<MarketSnapshot>& market,
+                  double dt, std::vector<OrderMessage>& out) override;
+
+private:
+    std::vector<double> thresholds;
+    std::vector<double> fastAverages;
+    std::vector<double> slowAverages;
+    double fastHalfLife;
+    double slowHalfLife;
+    double tradeRate;
+    double quantity;
+    std::mt19937_64 rng;
+};
+
+// Self-exciting arrivals: per asset the intensity is mu + sum(alpha * exp(-beta * age))
+// over past events, giving clustered, bursty flow.
+class HawkesTraders : public AgentModel {
+public:
+    HawkesTraders(size_t assetCount, double baseIntensity, double alpha, double beta,
+                  double maxQuantity = 500.0, uint64_t seed = 4);
+    const char* name() const override { return "hawkes"; }
+    void generate(const std::vector<uint16_t>& assetIds, const std::vector<MarketSnapshot>& market,
+                  double dt, std::vector<OrderMessage>& out) override;
+
+private:
+    std::vector<double> excitations;
+    double baseIntensity;
+    double alpha;
+    double beta;
+    double maxQuantity;
+    std::mt19937_64 rng;
+};
+
+#endif
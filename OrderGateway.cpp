@@ -0,0 +1,432 @@
+#include "OrderGateway.h"
+#include "OrderGenerator.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+// Ids 0-2 in epoll data are the listeners and the wakeup; connections count up from 3.
+const uint64_t UNIX_LISTENER{0};
+const uint64_t TCP_LISTENER{1};
+const uint64_t WAKEUP{2};
+const size_t READ_CHUNK{65536};
+const int MAX_EVENTS{64};
+const double QUANTITY_EPSILON{1e-9};
+
+size_t messageSize(uint8_t type) {
+    switch (static_cast<GatewayMessageType>(type)) {
+        case GatewayMessageType::NewOrder: return sizeof(GatewayNewOrder);
+        case GatewayMessageType::Cancel: return sizeof(GatewayCancel);
+        default: return 0;
+    }
+}
+
+int64_t nowNanos() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+}
+
+OrderGateway::OrderGateway(OrderBookManager& orderBook, const GatewayConfig& gatewayConfig)
+    : manager(orderBook), config(gatewayConfig) {}
+
+OrderGateway::~OrderGateway() {
+    stop();
+}
+
+GatewayStats OrderGateway::getStats() const {
+    lock_guard<mutex> lock(stateMutex);
+    return GatewayStats{connectionCount.load(memory_order_relaxed), orderCount.load(memory_order_relaxed),
+                        cancelCount.load(memory_order_relaxed), rejectCount.load(memory_order_relaxed),
+                        fillCount.load(memory_order_relaxed), owners.size()};
+}
+
+#ifndef _WIN32
+
+namespace {
+void wake(int eventFd) {
+    uint64_t one{1};
+    ssize_t written{write(eventFd, &one, sizeof(one))};
+    (void)written;
+}
+
+int listenUnix(const string& path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) return -1;
+    int fd{socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+    if (fd < 0) return -1;
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    // A socket file left by an earlier run would make bind fail.
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int listenTcp(uint16_t port) {
+    int fd{socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+    if (fd < 0) return -1;
+    int reuse{1};
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool watch(int epollFd, int fd, uint64_t id, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = id;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+}
+
+bool OrderGateway::start() {
+    if (isRunning()) return true;
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0 || !watch(epollFd, wakeFd, WAKEUP, EPOLLIN)) {
+        cerr << "Error: unable to set up the order gateway event loop" << endl;
+        stop();
+        return false;
+    }
+    if (!config.unixPath.empty()) {
+        unixFd = listenUnix(config.unixPath);
+        if (unixFd < 0 || !watch(epollFd, unixFd, UNIX_LISTENER, EPOLLIN)) {
+            cerr << "Error: order gateway cannot listen on " << config.unixPath << endl;
+            stop();
+            return false;
+        }
+    }
+    if (config.tcpPort != 0) {
+        tcpFd = listenTcp(config.tcpPort);
+        if (tcpFd < 0 || !watch(epollFd, tcpFd, TCP_LISTENER, EPOLLIN)) {
+            cerr << "Error: order gateway cannot listen on 127.0.0.1:" << config.tcpPort << endl;
+            stop();
+            return false;
+        }
+    }
+
+    if (!listenerAttached) {
+        manager.addExecutionListener([this](const string&, const Execution& execution) { onExecution(execution); });
+        manager.addOrderDoneListener([this](int orderId) { onOrderDone(orderId); });
+        listenerAttached = true;
+    }
+    running.store(true, memory_order_release);
+    loop = thread([this] { run(); });
+    return true;
+}
+
+void OrderGateway::stop() {
+    running.store(false, memory_order_release);
+    if (wakeFd >= 0) wake(wakeFd);
+    if (loop.joinable()) loop.join();
+    closeAll();
+    if (unixFd >= 0) unlink(config.unixPath.c_str());
+    for (int* fd : {&unixFd, &tcpFd, &wakeFd, &epollFd}) {
+        if (*fd >= 0) ::close(*fd);
+        *fd = -1;
+    }
+}
+
+void OrderGateway::run() {
+    loopThread = this_thread::get_id();
+    epoll_event events[MAX_EVENTS];
+    while (running.load(memory_order_acquire)) {
+        int ready{epoll_wait(epollFd, events, MAX_EVENTS, -1)};
+        for (int i = 0; i < ready; ++i) {
+            uint64_t id{events[i].data.u64};
+            if (id == WAKEUP) {
+                uint64_t count;
+                ssize_t drained{read(wakeFd, &count, sizeof(count))};
+                (void)drained;
+            } else if (id == UNIX_LISTENER) {
+                accept(unixFd);
+            } else if (id == TCP_LISTENER) {
+                accept(tcpFd);
+            } else if (events[i].events & EPOLLOUT) {
+                lock_guard<mutex> lock(stateMutex);
+                auto it{connections.find(id)};
+                if (it != connections.end()) it->second.writeBlocked = false;
+                pendingFlush.push_back(id);
+            }
+            if (id > WAKEUP && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) readFrom(id);
+        }
+
+        // Everything this wakeup produced leaves in one write per connection.
+        lock_guard<mutex> lock(stateMutex);
+        for (uint64_t id : pendingFlush) flush(id);
+        pendingFlush.clear();
+    }
+}
+
+void OrderGateway::accept(int listenFd) {
+    while (true) {
+        int fd{accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)};
+        if (fd < 0) return;
+        lock_guard<mutex> lock(stateMutex);
+        if (connections.size() >= config.maxClients) {
+            ::close(fd);
+            continue;
+        }
+        int noDelay{1};
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        uint64_t id{nextConnection++};
+        if (!watch(epollFd, fd, id, EPOLLIN | EPOLLRDHUP)) {
+            ::close(fd);
+            continue;
+        }
+        Connection& connection{connections[id]};
+        connection.fd = fd;
+        connection.input.resize(READ_CHUNK + sizeof(GatewayNewOrder));
+        connectionCount.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void OrderGateway::readFrom(uint64_t id) {
+    int fd;
+    char* buffer;
+    size_t used;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        auto it{connections.find(id)};
+        if (it == connections.end()) return;
+        fd = it->second.fd;
+        buffer = it->second.input.data();
+        used = it->second.inputSize;
+    }
+
+    // Only this thread resizes or erases connections, so the buffer stays valid unlocked.
+    ssize_t received{recv(fd, buffer + used, READ_CHUNK, 0)};
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        lock_guard<mutex> lock(stateMutex);
+        close(id);
+        return;
+    }
+    if (received < 0) return;
+
+    bool malformed{false};
+    size_t size{used + static_cast<size_t>(received)};
+    size_t consumed{handle(id, buffer, size, malformed)};
+
+    lock_guard<mutex> lock(stateMutex);
+    if (malformed) {
+        cerr << "Order gateway closed a client that sent an unknown message type" << endl;
+        close(id);
+        return;
+    }
+    // A partial message waits at the front of the buffer for the rest.
+    memmove(buffer, buffer + consumed, size - consumed);
+    auto it{connections.find(id)};
+    if (it != connections.end()) it->second.inputSize = size - consumed;
+}
+
+size_t OrderGateway::handle(uint64_t id, const char* data, size_t size, bool& malformed) {
+    size_t offset{0};
+    while (offset < size) {
+        size_t length{messageSize(static_cast<uint8_t>(data[offset]))};
+        if (length == 0) {
+            malformed = true;
+            return offset;
+        }
+        if (size - offset < length) break;
+        if (static_cast<GatewayMessageType>(data[offset]) == GatewayMessageType::NewOrder) {
+            GatewayNewOrder request;
+            memcpy(&request, data + offset, sizeof(request));
+            handleNewOrder(id, request);
+        } else {
+            GatewayCancel request;
+            memcpy(&request, data + offset, sizeof(request));
+            handleCancel(id, request);
+        }
+        offset += length;
+    }
+    return offset;
+}
+
+void OrderGateway::handleNewOrder(uint64_t id, const GatewayNewOrder& request) {
+    GatewayAck ack{GatewayMessageType::Ack, AckStatus::Accepted, 0, 0, request.clientOrderId, nowNanos()};
+    int assetId{getAssetId(string(request.symbol, strnlen(request.symbol, sizeof(request.symbol))))};
+    bool priced{request.orderType == OrderType::Market || request.price > 0};
+    if (assetId < 0) {
+        ack.status = AckStatus::UnknownSymbol;
+    } else if (request.quantity == 0 || !priced || request.side > Side::Sell ||
+               request.orderType > OrderType::StopLimit || request.timeInForce > TimeInForce::GTT) {
+        ack.status = AckStatus::InvalidOrder;
+    }
+    if (ack.status != AckStatus::Accepted) {
+        rejectCount.fetch_add(1, memory_order_relaxed);
+        lock_guard<mutex> lock(stateMutex);
+        queue(id, &ack, sizeof(ack));
+        return;
+    }
+
+    OrderMessage message{};
+    message.timestamp = ack.timestamp;
+    message.price = request.price;
+    message.quantity = request.quantity;
+    message.orderId = static_cast<uint32_t>(manager.allocateOrderId());
+    message.assetId = static_cast<uint16_t>(assetId);
+    message.side = request.side;
+    message.type = request.orderType;
+    message.flags = request.flags;
+    message.timeInForce = request.timeInForce;
+    message.expirySeconds = request.expirySeconds;
+    ack.orderId = message.orderId;
+    {
+        // The ack is queued first so the client never sees a fill for an order it has no id for.
+        lock_guard<mutex> lock(stateMutex);
+        queue(id, &ack, sizeof(ack));
+        owners[static_cast<int>(message.orderId)] =
+            Owner{id, request.clientOrderId, request.side, lotsToQuantity(request.quantity)};
+    }
+    orderCount.fetch_add(1, memory_order_relaxed);
+    lock_guard<mutex> engine(manager.getEngineMutex());
+    manager.processNewOrder(message);
+}
+
+void OrderGateway::handleCancel(uint64_t id, const GatewayCancel& request) {
+    GatewayAck ack{GatewayMessageType::Ack, AckStatus::UnknownOrder, 0, request.orderId, request.clientOrderId, 0};
+    bool owned;
+    {
+        lock_guard<mutex> lock(stateMutex);
+        auto it{owners.find(static_cast<int>(request.orderId))};
+        owned = it != owners.end() && it->second.connection == id;
+    }
+    if (owned) {
+        lock_guard<mutex> engine(manager.getEngineMutex());
+        if (manager.cancelOrder(static_cast<int>(request.orderId))) {
+            ack.status = AckStatus::Cancelled;
+            cancelCount.fetch_add(1, memory_order_relaxed);
+        }
+    }
+    ack.timestamp = nowNanos();
+
+    lock_guard<mutex> lock(stateMutex);
+    queue(id, &ack, sizeof(ack));
+}
+
+void OrderGateway::onExecution(const Execution& execution) {
+    bool wakeLoop{false};
+    {
+        lock_guard<mutex> lock(stateMutex);
+        if (owners.empty()) return;
+        size_t before{pendingFlush.size()};
+        fillOwner(execution.buyOrderId, execution.price, execution.quantity, execution.timestamp);
+        fillOwner(execution.sellOrderId, execution.price, execution.quantity, execution.timestamp);
+        wakeLoop = pendingFlush.size() > before && this_thread::get_id() != loopThread;
+    }
+    if (wakeLoop) wake(wakeFd);
+}
+
+void OrderGateway::onOrderDone(int orderId) {
+    lock_guard<mutex> lock(stateMutex);
+    owners.erase(orderId);
+}
+
+void OrderGateway::fillOwner(int orderId, double price, double quantity, int64_t timestamp) {
+    auto it{owners.find(orderId)};
+    if (it == owners.end()) return;
+    Owner& owner{it->second};
+    GatewayFill fill{GatewayMessageType::Fill, owner.side, 0, static_cast<uint32_t>(orderId), owner.clientOrderId,
+                     priceToTicks(price), quantityToLots(quantity), 0, timestamp};
+    queue(owner.connection, &fill, sizeof(fill));
+    fillCount.fetch_add(1, memory_order_relaxed);
+    owner.remaining -= quantity;
+    if (owner.remaining <= QUANTITY_EPSILON) owners.erase(it);
+}
+
+void OrderGateway::queue(uint64_t id, const void* message, size_t size) {
+    auto it{connections.find(id)};
+    if (it == connections.end()) return;
+    const char* bytes{static_cast<const char*>(message)};
+    it->second.output.insert(it->second.output.end(), bytes, bytes + size);
+    pendingFlush.push_back(id);
+}
+
+void OrderGateway::flush(uint64_t id) {
+    auto it{connections.find(id)};
+    if (it == connections.end() || it->second.output.empty() || it->second.writeBlocked) return;
+    Connection& connection{it->second};
+    size_t sent{0};
+    while (sent < connection.output.size()) {
+        ssize_t written{send(connection.fd, connection.output.data() + sent, connection.output.size() - sent,
+                             MSG_NOSIGNAL)};
+        if (written > 0) {
+            sent += static_cast<size_t>(written);
+        } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // The client is not reading; resume once the socket drains.
+            connection.writeBlocked = true;
+            if (!connection.writeArmed) {
+                epoll_event event{};
+                event.events = EPOLLIN | EPOLLRDHUP | EPOLLOUT;
+                event.data.u64 = id;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+                connection.writeArmed = true;
+            }
+            break;
+        } else if (written < 0 && errno == EINTR) {
+            continue;
+        } else {
+            close(id);
+            return;
+        }
+    }
+    connection.output.erase(connection.output.begin(), connection.output.begin() + sent);
+    if (connection.output.empty() && connection.writeArmed) {
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = id;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.writeArmed = false;
+    }
+}
+
+void OrderGateway::close(uint64_t id) {
+    auto it{connections.find(id)};
+    if (it == connections.end()) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    ::close(it->second.fd);
+    connections.erase(it);
+    for (auto owner = owners.begin(); owner != owners.end();) {
+        owner = owner->second.connection == id ? owners.erase(owner) : next(owner);
+    }
+}
+
+void OrderGateway::closeAll() {
+    lock_guard<mutex> lock(stateMutex);
+    for (auto& [id, connection] : connections) ::close(connection.fd);
+    connections.clear();
+    owners.clear();
+    pendingFlush.clear();
+}
+
+#else
+
+bool OrderGateway::start() {
+    cerr << "The order gateway needs epoll and is not available on this platform" << endl;
+    return false;
+}
+
+void OrderGateway::stop() {}
+
+#endif
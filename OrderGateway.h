@@ -0,0 +1,186 @@
+#ifndef ORDER_GATEWAY_H
+#define ORDER_GATEWAY_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "OrderBookManager.h"
+#include "OrderMessage.h"
+
+// Wire protocol: a stream of fixed-size messages in native byte order, each starting with its
+// GatewayMessageType byte. Clients send NewOrder and Cancel; the gateway answers every one
+// with an Ack and sends a Fill for each execution of an order the connection entered.
+// Prices are PRICE_SCALE ticks and quantities QUANTITY_SCALE lots, as in OrderMessage.
+// An unknown type byte closes the connection.
+enum class GatewayMessageType : uint8_t {
+    NewOrder = 1,
+    Cancel = 2,
+    Ack = 3,
+    Fill = 4
+};
+
+enum class AckStatus : uint8_t {
+    Accepted = 0,
+    Cancelled = 1,
+    UnknownSymbol = 2,
+    InvalidOrder = 3,
+    // Cancel of an order this connection does not own, or one the engine cannot cancel
+    // (only DAY and GTT orders are tracked individually).
+    UnknownOrder = 4
+};
+
+// symbol is NUL-padded and must be one of ASSETS. For stops price is the trigger, and a
+// StopLimit also uses it as its limit; a Market order ignores it.
+struct GatewayNewOrder {
+    GatewayMessageType type;
+    Side side;
+    OrderType orderType;
+    TimeInForce timeInForce;
+    uint16_t expirySeconds;
+    uint8_t flags;
+    uint8_t reserved;
+    char symbol[8];
+    uint64_t clientOrderId;
+    int64_t price;
+    uint32_t quantity;
+    uint32_t reserved2;
+};
+
+struct GatewayCancel {
+    GatewayMessageType type;
+    uint8_t reserved[3];
+    uint32_t orderId;
+    uint64_t clientOrderId;
+};
+
+// orderId is the engine id given to an accepted order, to be used by Cancel.
+struct GatewayAck {
+    GatewayMessageType type;
+    AckStatus status;
+    uint16_t reserved;
+    uint32_t orderId;
+    uint64_t clientOrderId;
+    int64_t timestamp;
+};
+
+struct GatewayFill {
+    GatewayMessageType type;
+    Side side;
+    uint16_t reserved;
+    uint32_t orderId;
+    uint64_t clientOrderId;
+    int64_t price;
+    uint32_t quantity;
+    uint32_t reserved2;
+    int64_t timestamp;
+};
+
+static_assert(sizeof(GatewayNewOrder) == 40, "GatewayNewOrder layout is part of the protocol");
+static_assert(sizeof(GatewayCancel) == 16, "GatewayCancel layout is part of the protocol");
+static_assert(sizeof(GatewayAck) == 24, "GatewayAck layout is part of the protocol");
+static_assert(sizeof(GatewayFill) == 40, "GatewayFill layout is part of the protocol");
+static_assert(std::is_trivially_copyable<GatewayNewOrder>::value, "gateway messages must be memcpy-able");
+
+// An empty unixPath or a zero tcpPort leaves that listener off; TCP binds to 127.0.0.1 only.
+struct GatewayConfig {
+    std::string unixPath{"lob_gateway.sock"};
+    uint16_t tcpPort{0};
+    size_t maxClients{256};
+};
+
+struct GatewayStats {
+    uint64_t connections{0};
+    uint64_t orders{0};
+    uint64_t cancels{0};
+    uint64_t rejects{0};
+    uint64_t fills{0};
+    // Orders whose fills the gateway still routes.
+    uint64_t openOrders{0};
+};
+
+// Binary order entry for local processes. One thread runs a non-blocking epoll loop: each
+// readable connection is drained in one read of up to 64 KB, every complete message in it is
+// handled, and the acks and fills produced by the whole wakeup leave in a single write per
+// connection. Accepted orders go to processNewOrder(OrderMessage) on that thread under the
+// manager's engine mutex, which the console and the simulator take as well. Fills from trades
+// made on other threads are queued under a lock and wake the loop through an eventfd.
+// Needs epoll: start fails on other platforms.
+class OrderGateway {
+public:
+    explicit OrderGateway(OrderBookManager& manager, const GatewayConfig& config = GatewayConfig{});
+    ~OrderGateway();
+    OrderGateway(const OrderGateway&) = delete;
+    OrderGateway& operator=(const OrderGateway&) = delete;
+
+    bool start();
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    GatewayStats getStats() const;
+
+private:
+    struct Connection {
+        int fd;
+        std::vector<char> input;
+        size_t inputSize{0};
+        std::vector<char> output;
+        // writeBlocked: the last send hit EAGAIN; writeArmed: EPOLLOUT is registered.
+        bool writeBlocked{false};
+        bool writeArmed{false};
+    };
+    // Where an order entered, so its fills go back there. Kept until the order is filled or the
+    // engine reports it done (expired, cancelled or dropped).
+    struct Owner {
+        uint64_t connection;
+        uint64_t clientOrderId;
+        Side side;
+        double remaining;
+    };
+
+    OrderBookManager& manager;
+    GatewayConfig config;
+    std::thread loop;
+    std::atomic<bool> running{false};
+    std::thread::id loopThread;
+    int epollFd{-1};
+    int wakeFd{-1};
+    int unixFd{-1};
+    int tcpFd{-1};
+    bool listenerAttached{false};
+
+    // Guards connections and owners, which execution listeners on other threads also touch.
+    // Never held while taking the engine mutex: listeners take it under that one.
+    mutable std::mutex stateMutex;
+    std::unordered_map<uint64_t, Connection> connections;
+    std::unordered_map<int, Owner> owners;
+    uint64_t nextConnection{3};
+    std::vector<uint64_t> pendingFlush;
+
+    std::atomic<uint64_t> connectionCount{0};
+    std::atomic<uint64_t> orderCount{0};
+    std::atomic<uint64_t> cancelCount{0};
+    std::atomic<uint64_t> rejectCount{0};
+    std::atomic<uint64_t> fillCount{0};
+
+    void run();
+    void accept(int listenFd);
+    void readFrom(uint64_t id);
+    size_t handle(uint64_t id, const char* data, size_t size, bool& malformed);
+    void handleNewOrder(uint64_t id, const GatewayNewOrder& request);
+    void handleCancel(uint64_t id, const GatewayCancel& request);
+    void onExecution(const Execution& execution);
+    void onOrderDone(int orderId);
+    void fillOwner(int orderId, double price, double quantity, int64_t timestamp);
+    // Callers hold stateMutex.
+    void queue(uint64_t id, const void* message, size_t size);
+    void flush(uint64_t id);
+    void close(uint64_t id);
+    void closeAll();
+};
+
+#endif
@@ -5,6 +5,13 @@ using namespace std;
 
 const vector<string> ASSETS {"AAPL", "TSLA", "GOOG", "MSFT", "AMZN", "META", "NFLX", "NVDA"};
 
+int getAssetId(const string& asset) {
+    for (size_t i = 0; i < ASSETS.size(); ++i) {
+        if (ASSETS[i] == asset) return static_cast<int>(i);
+    }
+    return -1;
+}
+
 double generateRandomNormal(double mean, double variance) {
     static random_device rd;
     static mt19937 gen(rd());
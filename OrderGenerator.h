@@ -15,6 +15,8 @@
 
 extern const std::vector<std::string> ASSETS;
 
+int getAssetId(const std::string& asset);
+
 double generateRandomNormal(double mean, double variance);
 double generateRandomUniform(double lower, double upper);
 double roundToTickSize(double value, double tickSize);
@@ -0,0 +1,62 @@
+#include "OrderMessage.h"
+#include "OrderGenerator.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+using namespace std;
+
+const string& assetSymbol(uint16_t assetId) {
+    static const string unknown;
+    return assetId < ASSETS.size() ? ASSETS[assetId] : unknown;
+}
+
+bool toMessage(const Order& order, OrderMessage& message) {
+    int assetId{getAssetId(order.asset)};
+    if (assetId < 0 || order.price <= 0 || order.quantity <= 0) return false;
+    if (order.quantity * QUANTITY_SCALE > numeric_limits<uint32_t>::max()) return false;
+    if (order.orderType == OrderType::StopLimit && priceToTicks(order.stopPrice) != priceToTicks(order.price)) return false;
+
+    memset(&message, 0, sizeof(message));
+    message.timestamp = chrono::duration_cast<chrono::nanoseconds>(order.dateTime.time_since_epoch()).count();
+    message.price = priceToTicks(order.orderType == OrderType::Stop ? order.stopPrice : order.price);
+    message.quantity = quantityToLots(order.quantity);
+    message.orderId = static_cast<uint32_t>(order.id);
+    message.assetId = static_cast<uint16_t>(assetId);
+    message.side = order.type == "BUY" ? Side::Buy : Side::Sell;
+    message.type = order.orderType;
+    message.flags = order.isShortSell ? ORDER_FLAG_SHORT_SELL : ORDER_FLAG_NONE;
+    message.timeInForce = order.timeInForce;
+    if (order.timeInForce == TimeInForce::GTT) {
+        int64_t lifetime{chrono::duration_cast<chrono::nanoseconds>(order.expireTime - order.dateTime).count()};
+        int64_t seconds{max<int64_t>((lifetime + 999999999) / 1000000000, 0)};
+        message.expirySeconds = static_cast<uint16_t>(min<int64_t>(seconds, numeric_limits<uint16_t>::max()));
+    }
+    return true;
+}
+
+Order toOrder(const OrderMessage& message) {
+    Order order;
+    order.id = static_cast<int>(message.orderId);
+    order.asset = assetSymbol(message.assetId);
+    order.type = message.side == Side::Buy ? "BUY" : "SELL";
+    order.isShortSell = (message.flags & ORDER_FLAG_SHORT_SELL) != 0;
+    order.price = ticksToPrice(message.price);
+    order.orderType = message.type;
+    if (message.type == OrderType::Stop || message.type == OrderType::StopLimit) order.stopPrice = order.price;
+    order.quantity = lotsToQuantity(message.quantity);
+    order.totalAmount = order.price * order.quantity;
+    order.dateTime = chrono::system_clock::time_point(
+        chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(message.timestamp)));
+    order.timeInForce = message.timeInForce;
+    if (message.timeInForce == TimeInForce::GTT) {
+        order.expireTime = order.dateTime + chrono::seconds(message.expirySeconds);
+    }
+
+    time_t seconds{chrono::system_clock::to_time_t(order.dateTime)};
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+    order.timestamp = buffer;
+    return order;
+}
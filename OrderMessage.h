@@ -0,0 +1,77 @@
+#ifndef ORDER_MESSAGE_H
+#define ORDER_MESSAGE_H
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+struct Order;
+
+enum class Side : uint8_t {
+    Buy = 0,
+    Sell = 1
+};
+
+// Stop orders wait for a trade at or through their trigger (at or above for buys, at or below
+// for sells); a Stop then becomes a market order and a StopLimit a limit order.
+enum class OrderType : uint8_t {
+    Limit = 0,
+    Market = 1,
+    Stop = 2,
+    StopLimit = 3
+};
+
+// GTC rests until filled or cancelled, DAY until the end of the local day of its timestamp,
+// GTT until an explicit expiry time.
+enum class TimeInForce : uint8_t {
+    GTC = 0,
+    DAY = 1,
+    GTT = 2
+};
+
+enum OrderFlags : uint8_t {
+    ORDER_FLAG_NONE = 0,
+    ORDER_FLAG_SHORT_SELL = 1 << 0
+};
+
+// Fixed-point scales: prices in 1/10000 units, quantities in 1/1000 units.
+const int64_t PRICE_SCALE{10000};
+const int64_t QUANTITY_SCALE{1000};
+
+// Hot-path order: 32 bytes, trivially copyable, two per cache line. assetId indexes ASSETS,
+// timestamp is nanoseconds since the epoch and a GTT order expires expirySeconds after it.
+// For stops price is the trigger, and a StopLimit also uses it as its limit.
+// Strings only appear at the edges via toOrder/toMessage.
+struct OrderMessage {
+    int64_t timestamp;
+    int64_t price;
+    uint32_t quantity;
+    uint32_t orderId;
+    uint16_t assetId;
+    Side side;
+    OrderType type;
+    uint8_t flags;
+    TimeInForce timeInForce;
+    uint16_t expirySeconds;
+};
+
+static_assert(sizeof(OrderMessage) == 32, "OrderMessage must stay 32 bytes");
+static_assert(std::is_trivially_copyable<OrderMessage>::value, "OrderMessage must be memcpy-able");
+
+inline int64_t priceToTicks(double price) { return std::llround(price * PRICE_SCALE); }
+inline double ticksToPrice(int64_t ticks) { return static_cast<double>(ticks) / PRICE_SCALE; }
+inline uint32_t quantityToLots(double quantity) { return static_cast<uint32_t>(std::llround(quantity * QUANTITY_SCALE)); }
+inline double lotsToQuantity(uint32_t lots) { return static_cast<double>(lots) / QUANTITY_SCALE; }
+
+// Symbol for an asset id, or an empty string when the id is out of range.
+const std::string& assetSymbol(uint16_t assetId);
+
+// Fails for assets outside ASSETS, non-positive prices, quantities that do not fit the message
+// and stop-limits whose limit differs from their trigger.
+// GTT lifetimes are rounded up to whole seconds and capped at about 18 hours.
+bool toMessage(const Order& order, OrderMessage& message);
+// Fills every Order field, including the formatted timestamp.
+Order toOrder(const OrderMessage& message);
+
+#endif
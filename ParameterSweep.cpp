@@ -0,0 +1,307 @@
+#include "ParameterSweep.h"
+#include "AsyncLogger.h"
+#include "InputJournal.h"
+#include "OrderBookManager.h"
+#include "OrderGenerator.h"
+#include "Portfolio.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+using namespace std;
+
+namespace {
+const double QUANTITY_EPSILON{1e-9};
+// Far above recorded order ids, so a quote never takes over a recorded order.
+const uint32_t FIRST_QUOTE_ID{1u << 30};
+// The longest GTT a message carries; quotes are replaced long before.
+const uint16_t QUOTE_LIFETIME{65535};
+
+// quantity is what rested after the quote's own aggressive fills; levelId and queuePosition
+// place it in its level as the engine does (see OrderBookManager::RestingOrder), and traded
+// is the volume executed at its price since.
+struct Quote {
+    int id{0};
+    double price{0.0};
+    double quantity{0.0};
+    uint64_t levelId{0};
+    double queuePosition{0.0};
+    double traded{0.0};
+    double filled{0.0};
+};
+
+// mid is zero while either side of the book is empty. touched: the asset's statistics or
+// trades changed since the strategy last looked.
+struct QuotedAsset {
+    const string* asset{nullptr};
+    uint16_t assetId{0};
+    const BidBook* bids{nullptr};
+    const AskBook* asks{nullptr};
+    double mid{0.0};
+    double held{0.0};
+    bool touched{false};
+    bool filledSinceQuote{false};
+    int64_t nextQuote{0};
+    Quote bid;
+    Quote ask;
+};
+
+class QuotingStrategy {
+public:
+    QuotingStrategy(OrderBookManager& manager, Portfolio& portfolio, const StrategyParams& params,
+                    SweepResult& result)
+        : manager(manager), portfolio(portfolio), params(params), result(result) {
+        assets.resize(ASSETS.size());
+        for (size_t i = 0; i < ASSETS.size(); ++i) {
+            assets[i].asset = &ASSETS[i];
+            assets[i].assetId = static_cast<uint16_t>(i);
+        }
+        manager.addStatisticsListener([this](const string& asset, const OrderBookStatistics& stats) {
+            this->portfolio.onStatisticsUpdate(asset, stats);
+            if (QuotedAsset* quoted{find(asset)}) {
+                quoted->mid = stats.bidPrice > 0 && stats.askPrice > 0 ? stats.midPrice : 0.0;
+                quoted->touched = true;
+            }
+        });
+        manager.addExecutionListener([this](const string& asset, const Execution& execution) {
+            onExecution(asset, execution);
+        });
+    }
+
+    // Settles the quotes of every asset the last record touched and replaces them when due.
+    void afterRecord() {
+        int64_t clock{manager.getClock()};
+        for (QuotedAsset& asset : assets) {
+            if (!asset.touched) continue;
+            asset.touched = false;
+            settle(asset, asset.bid, true);
+            settle(asset, asset.ask, false);
+            if (asset.filledSinceQuote || clock >= asset.nextQuote) requote(asset, clock);
+        }
+    }
+
+    void finish() {
+        for (const QuotedAsset& asset : assets) {
+            result.realizedPnL += portfolio.getRealizedPnL(*asset.asset);
+            result.inventory += asset.held;
+        }
+        result.unrealizedPnL = portfolio.getUnrealizedPnL();
+    }
+
+private:
+    OrderBookManager& manager;
+    Portfolio& portfolio;
+    const StrategyParams& params;
+    SweepResult& result;
+    vector<QuotedAsset> assets;
+    uint32_t nextId{FIRST_QUOTE_ID};
+    // The quote being sent: its executions are its own aggressive fills.
+    int placingId{0};
+    bool placingBuy{false};
+    double placedFilled{0.0};
+
+    QuotedAsset* find(const string& asset) {
+        for (QuotedAsset& quoted : assets) {
+            if (*quoted.asset == asset) return &quoted;
+        }
+        return nullptr;
+    }
+
+    void onExecution(const string& asset, const Execution& execution) {
+        QuotedAsset* quoted{find(asset)};
+        if (!quoted) return;
+        if (placingId != 0 && (placingBuy ? execution.buyOrderId : execution.sellOrderId) == placingId) {
+            book(*quoted, placingBuy, execution.quantity, execution.price);
+            placedFilled += execution.quantity;
+            return;
+        }
+        quoted->touched = true;
+        if (quoted->bid.id != 0 && execution.price == quoted->bid.price) quoted->bid.traded += execution.quantity;
+        if (quoted->ask.id != 0 && execution.price == quoted->ask.price) quoted->ask.traded += execution.quantity;
+    }
+
+    void book(QuotedAsset& asset, bool isBuy, double quantity, double price) {
+        if (isBuy) {
+            portfolio.updateBuy(*asset.asset, quantity, price, "");
+            result.buyFills++;
+            result.boughtQuantity += quantity;
+        } else {
+            // Fills add up in floating point; a sale never goes beyond what the ledger holds.
+            quantity = min(quantity, portfolio.getQuantity(*asset.asset));
+            if (quantity <= 0) return;
+            portfolio.updateSell(*asset.asset, quantity, price, "");
+            result.sellFills++;
+            result.soldQuantity += quantity;
+        }
+        asset.held = portfolio.getQuantity(*asset.asset);
+        asset.filledSinceQuote = true;
+    }
+
+    const OrderBookEntry* level(QuotedAsset& asset, bool isBuy, double price) {
+        if (isBuy) {
+            if (!asset.bids) {
+                auto it{manager.getBidBooks().find(*asset.asset)};
+                if (it == manager.getBidBooks().end()) return nullptr;
+                asset.bids = &it->second;
+            }
+            auto it{asset.bids->find(price)};
+            return it == asset.bids->end() ? nullptr : &it->second;
+        }
+        if (!asset.asks) {
+            auto it{manager.getAskBooks().find(*asset.asset)};
+            if (it == manager.getAskBooks().end()) return nullptr;
+            asset.asks = &it->second;
+        }
+        auto it{asset.asks->find(price)};
+        return it == asset.asks->end() ? nullptr : &it->second;
+    }
+
+    // Books what the engine's queue has reached of the quote, capped by what traded at its
+    // price, and retires the quote once nothing of it is left in the book.
+    void settle(QuotedAsset& asset, Quote& quote, bool isBuy) {
+        if (quote.id == 0) return;
+        const OrderBookEntry* entry{level(asset, isBuy, quote.price)};
+        bool live{entry && entry->levelId == quote.levelId};
+        double reached{live ? entry->executedQuantity - quote.queuePosition : quote.quantity};
+        double filled{clamp(min(reached, quote.traded), 0.0, quote.quantity)};
+        if (filled - quote.filled > QUANTITY_EPSILON) {
+            book(asset, isBuy, filled - quote.filled, quote.price);
+            quote.filled = filled;
+        }
+        if (!live || reached >= quote.quantity - QUANTITY_EPSILON) withdraw(quote);
+    }
+
+    // Also drops the engine's expiry entry when the quote has already left the book.
+    void withdraw(Quote& quote) {
+        if (quote.id == 0) return;
+        manager.cancelOrder(quote.id);
+        quote = Quote{};
+    }
+
+    void requote(QuotedAsset& asset, int64_t clock) {
+        withdraw(asset.bid);
+        withdraw(asset.ask);
+        asset.filledSinceQuote = false;
+        asset.nextQuote = clock + static_cast<int64_t>(params.requoteSeconds * 1e9);
+        // Read after the withdrawals, so the quotes do not chase their own mid.
+        double mid{asset.mid};
+        if (mid > 0) {
+            double shift{params.maxInventory > 0 ? params.inventorySkew * asset.held / params.maxInventory : 0.0};
+            place(asset, asset.bid, true, mid * (1.0 - params.halfSpread - shift),
+                  min(params.quoteSize, params.maxInventory - asset.held));
+            place(asset, asset.ask, false, mid * (1.0 + params.halfSpread - shift), min(params.quoteSize, asset.held));
+        }
+        asset.touched = false;
+    }
+
+    void place(QuotedAsset& asset, Quote& quote, bool isBuy, double price, double quantity) {
+        // Bids round down and asks up to the price scale; quantities round down, so an ask
+        // never offers more than is held.
+        int64_t ticks{static_cast<int64_t>(isBuy ? floor(price * PRICE_SCALE) : ceil(price * PRICE_SCALE))};
+        uint32_t lots{quantity > 0 ? static_cast<uint32_t>(floor(quantity * QUANTITY_SCALE + 1e-6)) : 0};
+        if (ticks <= 0 || lots == 0) return;
+
+        OrderMessage message{manager.getClock(), ticks, lots, nextId++, asset.assetId, isBuy ? Side::Buy : Side::Sell,
+                             OrderType::Limit, ORDER_FLAG_NONE, TimeInForce::GTT, QUOTE_LIFETIME};
+        placingId = static_cast<int>(message.orderId);
+        placingBuy = isBuy;
+        placedFilled = 0.0;
+        manager.processNewOrder(message);
+        placingId = 0;
+        result.quotes++;
+        result.quotedQuantity += lotsToQuantity(lots);
+
+        double resting{lotsToQuantity(lots) - placedFilled};
+        const OrderBookEntry* entry{resting > QUANTITY_EPSILON ? level(asset, isBuy, ticksToPrice(ticks)) : nullptr};
+        if (!entry) return;
+        quote = Quote{static_cast<int>(message.orderId), entry->price, resting, entry->levelId,
+                      entry->queuedQuantity - resting};
+    }
+};
+
+void runConfig(const InputJournalReader& reader, const StrategyParams& params, SweepResult& result) {
+    auto start{chrono::steady_clock::now()};
+    result.params = params;
+    OrderBookManager manager("");
+    Portfolio portfolio;
+    QuotingStrategy strategy(manager, portfolio, params, result);
+    Order order{};
+    for (uint64_t i = 0; i < reader.size(); ++i) {
+        reader.apply(i, manager, order);
+        strategy.afterRecord();
+    }
+    strategy.finish();
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+}
+
+ParameterSweep::ParameterSweep(size_t threads) : pool(threads) {}
+
+bool ParameterSweep::run(const string& journalPath, const vector<StrategyParams>& configs) {
+    InputJournalReader reader(journalPath);
+    if (!reader.isOpen()) {
+        cerr << "Error: unable to open input journal " << journalPath << endl;
+        return false;
+    }
+    records = reader.size();
+    results.assign(configs.size(), SweepResult{});
+
+    AsyncLogger& logger{AsyncLogger::instance()};
+    LogLevel level{logger.getLevel()};
+    logger.setLevel(max(level, LogLevel::Warning));
+    auto start{chrono::steady_clock::now()};
+    for (size_t i = 0; i < configs.size(); ++i) {
+        pool.submit([&reader, &params = configs[i], &result = results[i]] { runConfig(reader, params, result); });
+    }
+    pool.wait();
+    seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    logger.setLevel(level);
+    return true;
+}
+
+vector<StrategyParams> ParameterSweep::grid(const vector<double>& halfSpreads, const vector<double>& quoteSizes,
+                                            const vector<double>& maxInventories,
+                                            const vector<double>& inventorySkews,
+                                            const vector<double>& requoteSeconds) {
+    vector<StrategyParams> configs;
+    for (double halfSpread : halfSpreads)
+        for (double quoteSize : quoteSizes)
+            for (double maxInventory : maxInventories)
+                for (double inventorySkew : inventorySkews)
+                    for (double requote : requoteSeconds)
+                        configs.push_back(StrategyParams{halfSpread, quoteSize, maxInventory, inventorySkew, requote});
+    return configs;
+}
+
+void ParameterSweep::report(ostream& out, size_t rows) const {
+    out << "Sweep: " << results.size() << " configurations over " << records << " records in " << fixed
+        << setprecision(3) << seconds << " s on " << pool.size() << " threads";
+    if (seconds > 0) out << " (" << setprecision(1) << results.size() / seconds << " runs/s)";
+    out << "\n";
+
+    vector<size_t> order(results.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(),
+                [this](size_t a, size_t b) { return results[a].totalPnL() > results[b].totalPnL(); });
+    if (rows == 0 || rows > order.size()) rows = order.size();
+
+    out << right << setw(8) << "SPREAD" << setw(8) << "SIZE" << setw(8) << "MAXINV" << setw(8) << "SKEW"
+        << setw(8) << "REQ s" << setw(12) << "REALIZED" << setw(12) << "UNREAL" << setw(12) << "TOTAL"
+        << setw(8) << "QUOTES" << setw(8) << "BUYS" << setw(8) << "SELLS" << setw(8) << "FILL%" << setw(10)
+        << "INV" << "\n";
+    for (size_t i = 0; i < rows; ++i) {
+        const SweepResult& r{results[order[i]]};
+        double filled{r.boughtQuantity + r.soldQuantity};
+        out << setprecision(4) << setw(8) << r.params.halfSpread << setprecision(1) << setw(8)
+            << r.params.quoteSize << setw(8) << r.params.maxInventory << setprecision(4) << setw(8)
+            << r.params.inventorySkew << setprecision(1) << setw(8) << r.params.requoteSeconds << setprecision(2)
+            << setw(12) << r.realizedPnL << setw(12) << r.unrealizedPnL << setw(12) << r.totalPnL() << setw(8)
+            << r.quotes << setw(8) << r.buyFills << setw(8) << r.sellFills << setprecision(1) << setw(8)
+            << (r.quotedQuantity > 0 ? 100.0 * filled / r.quotedQuantity : 0.0) << setw(10) << r.inventory
+            << "\n";
+    }
+    out << defaultfloat;
+}
@@ -0,0 +1,71 @@
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "WorkStealingPool.h"
+
+// One market-making setting, quoted on every asset of the stream. Quotes sit halfSpread either
+// side of the mid (relative to it), both shifted down by inventorySkew (relative) at
+// maxInventory held and proportionally below; bids stop at maxInventory and asks only offer
+// what is held, as a portfolio does not go short. Quotes are replaced after a fill and every
+// requoteSeconds of engine time (0: whenever their asset changes).
+struct StrategyParams {
+    double halfSpread{0.001};
+    double quoteSize{10.0};
+    double maxInventory{100.0};
+    double inventorySkew{0.0};
+    double requoteSeconds{0.0};
+};
+
+// PnL is summed over assets; unrealizedPnL marks what is still held at the last mid.
+struct SweepResult {
+    StrategyParams params;
+    double realizedPnL{0.0};
+    double unrealizedPnL{0.0};
+    uint64_t quotes{0};
+    double quotedQuantity{0.0};
+    uint64_t buyFills{0};
+    uint64_t sellFills{0};
+    double boughtQuantity{0.0};
+    double soldQuantity{0.0};
+    double inventory{0.0};
+    double seconds{0.0};
+
+    double totalPnL() const { return realizedPnL + unrealizedPnL; }
+};
+
+// Backtests many settings against one recorded input journal. The journal is mapped once and
+// read by every run; each setting gets its own OrderBookManager and Portfolio on a pool task,
+// replays the stream with the strategy's quotes trading against it, and leaves one row.
+// A passive quote is filled as the engine's queue model reaches it, never beyond the volume
+// traded at its price since it was placed.
+class ParameterSweep {
+public:
+    // threads 0: one per hardware thread.
+    explicit ParameterSweep(size_t threads = 0);
+
+    // False when the journal cannot be opened. Results follow the order of configs. Info
+    // logging is held back for the duration, as every simulated fill would log.
+    bool run(const std::string& journalPath, const std::vector<StrategyParams>& configs);
+    const std::vector<SweepResult>& getResults() const { return results; }
+    // Every combination of the given values.
+    static std::vector<StrategyParams> grid(const std::vector<double>& halfSpreads,
+                                            const std::vector<double>& quoteSizes,
+                                            const std::vector<double>& maxInventories,
+                                            const std::vector<double>& inventorySkews,
+                                            const std::vector<double>& requoteSeconds);
+    // Rows by total PnL, best first; rows 0: all of them.
+    void report(std::ostream& out, size_t rows = 0) const;
+
+private:
+    WorkStealingPool pool;
+    std::vector<SweepResult> results;
+    uint64_t records{0};
+    double seconds{0.0};
+};
+
+#endif
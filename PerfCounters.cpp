@@ -0,0 +1,249 @@
+#include "PerfCounters.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+// Indexed by PerfRegion and PerfEvent.
+const char* const REGION_NAMES[]{"processNewOrder", "updateStatistics", "loadOrders", "streamOrders",
+                                 "processOrders"};
+const char* const EVENT_NAMES[]{"task-clock ns", "cycles", "instructions", "L1d misses", "LLC misses",
+                                "branch misses"};
+
+static_assert(sizeof(REGION_NAMES) / sizeof(REGION_NAMES[0]) == PERF_REGION_COUNT, "every PerfRegion needs a name");
+static_assert(sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]) == PERF_EVENT_COUNT, "every PerfEvent needs a name");
+
+const int CALIBRATION_ROUNDS{64};
+}
+
+atomic<bool> PerfCounters::active{false};
+
+// One group per thread. slots maps a position in the group read to its PerfEvent.
+struct PerfCounters::ThreadCounters {
+    int leader{-1};
+    vector<int> fds;
+    vector<PerfEvent> slots;
+    bool failed{false};
+    PerfRegionStats regions[PERF_REGION_COUNT];
+    mutex statsMutex;
+
+#ifdef __linux__
+    ~ThreadCounters() {
+        for (int fd : fds) ::close(fd);
+    }
+#endif
+};
+
+PerfCounters& PerfCounters::instance() {
+    static PerfCounters counters;
+    return counters;
+}
+
+#ifdef __linux__
+
+namespace {
+void describe(PerfEvent event, perf_event_attr& attr) {
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    switch (event) {
+        case PerfEvent::TaskClock:
+            attr.type = PERF_TYPE_SOFTWARE;
+            attr.config = PERF_COUNT_SW_TASK_CLOCK;
+            break;
+        case PerfEvent::Cycles: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+        case PerfEvent::Instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+        case PerfEvent::L1DMisses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PerfEvent::LLCMisses: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+        case PerfEvent::BranchMisses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+        default: break;
+    }
+}
+
+int openEvent(perf_event_attr& attr, int groupFd) {
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+// Layout of a PERF_FORMAT_GROUP read.
+struct GroupRead {
+    uint64_t count;
+    uint64_t values[PERF_EVENT_COUNT];
+};
+}
+
+PerfCounters::ThreadCounters* PerfCounters::local() {
+    thread_local ThreadCounters* counters{nullptr};
+    if (counters) return counters->failed ? nullptr : counters;
+
+    auto owned{make_unique<ThreadCounters>()};
+    counters = owned.get();
+    for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+        PerfEvent event{static_cast<PerfEvent>(e)};
+        perf_event_attr attr;
+        describe(event, attr);
+        attr.read_format = PERF_FORMAT_GROUP;
+        // The group counts from its creation; regions only ever look at differences.
+        int fd{openEvent(attr, counters->leader)};
+        if (fd < 0) continue;
+        if (counters->leader < 0) counters->leader = fd;
+        counters->fds.push_back(fd);
+        counters->slots.push_back(event);
+    }
+    counters->failed = counters->leader < 0;
+
+    lock_guard<mutex> lock(threadsMutex);
+    threads.push_back(move(owned));
+    return counters->failed ? nullptr : counters;
+}
+
+bool PerfCounters::enable() {
+    if (enabled()) return true;
+    ThreadCounters* counters{local()};
+    if (!counters) {
+        cerr << "Performance counters unavailable (perf_event_open: " << strerror(errno)
+             << "); check /proc/sys/kernel/perf_event_paranoid or the container's seccomp profile" << endl;
+        return false;
+    }
+    availableEvents = 0;
+    for (PerfEvent event : counters->slots) availableEvents |= 1u << static_cast<unsigned>(event);
+    string missing;
+    for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (!available(static_cast<PerfEvent>(e))) missing += (missing.empty() ? "" : ", ") + string(EVENT_NAMES[e]);
+    }
+    if (!missing.empty()) cerr << "Performance counters not available here: " << missing << endl;
+
+    // The cheapest of many empty regions is the fixed cost of the two reads themselves.
+    fill(overhead, overhead + PERF_EVENT_COUNT, UINT64_MAX);
+    for (int round = 0; round < CALIBRATION_ROUNDS; ++round) {
+        PerfSample start, stop;
+        if (!begin(start) || !begin(stop)) break;
+        for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) overhead[e] = min(overhead[e], stop.values[e] - start.values[e]);
+    }
+    for (auto& value : overhead) {
+        if (value == UINT64_MAX) value = 0;
+    }
+    active.store(true, memory_order_relaxed);
+    return true;
+}
+
+bool PerfCounters::begin(PerfSample& sample) {
+    ThreadCounters* counters{local()};
+    if (!counters) return false;
+    GroupRead group;
+    if (read(counters->leader, &group, sizeof(group)) <= 0) return false;
+    for (size_t i = 0; i < counters->slots.size() && i < group.count; ++i) {
+        sample.values[static_cast<size_t>(counters->slots[i])] = group.values[i];
+    }
+    return true;
+}
+
+#else
+
+PerfCounters::ThreadCounters* PerfCounters::local() {
+    return nullptr;
+}
+
+bool PerfCounters::enable() {
+    cerr << "Performance counters need Linux perf_event_open" << endl;
+    return false;
+}
+
+bool PerfCounters::begin(PerfSample&) {
+    return false;
+}
+
+#endif
+
+void PerfCounters::end(PerfRegion region, const PerfSample& start) {
+    PerfSample stop;
+    if (!begin(stop)) return;
+    ThreadCounters* counters{local()};
+    // Only the owning thread writes its stats; the lock is uncontended unless a report runs.
+    lock_guard<mutex> lock(counters->statsMutex);
+    PerfRegionStats& stats{counters->regions[static_cast<size_t>(region)]};
+    ++stats.calls;
+    for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+        uint64_t delta{stop.values[e] - start.values[e]};
+        stats.totals[e] += delta > overhead[e] ? delta - overhead[e] : 0;
+    }
+}
+
+void PerfCounters::reset() {
+    lock_guard<mutex> lock(threadsMutex);
+    for (auto& counters : threads) {
+        lock_guard<mutex> statsLock(counters->statsMutex);
+        fill(counters->regions, counters->regions + PERF_REGION_COUNT, PerfRegionStats{});
+    }
+}
+
+PerfRegionStats PerfCounters::stats(PerfRegion region) const {
+    PerfRegionStats sum;
+    lock_guard<mutex> lock(threadsMutex);
+    for (const auto& counters : threads) {
+        lock_guard<mutex> statsLock(counters->statsMutex);
+        const PerfRegionStats& stats{counters->regions[static_cast<size_t>(region)]};
+        sum.calls += stats.calls;
+        for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) sum.totals[e] += stats.totals[e];
+    }
+    return sum;
+}
+
+void PerfCounters::report(ostream& out) const {
+    out << "\nPerformance counters (per call, user space)\n";
+    out << setw(18) << left << "REGION" << right << setw(10) << "CALLS";
+    for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (available(static_cast<PerfEvent>(e))) out << setw(15) << EVENT_NAMES[e];
+    }
+    out << setw(8) << "IPC" << setw(12) << "LLC/kinstr" << "\n";
+
+    out << fixed << setprecision(1);
+    for (size_t r = 0; r < PERF_REGION_COUNT; ++r) {
+        PerfRegionStats region{stats(static_cast<PerfRegion>(r))};
+        if (region.calls == 0) continue;
+        out << setw(18) << left << REGION_NAMES[r] << right << setw(10) << region.calls;
+        for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+            if (available(static_cast<PerfEvent>(e))) out << setw(15) << region.perCall(static_cast<PerfEvent>(e));
+        }
+        double instructions{region.perCall(PerfEvent::Instructions)};
+        double cycles{region.perCall(PerfEvent::Cycles)};
+        if (cycles > 0) {
+            out << setw(8) << setprecision(2) << instructions / cycles;
+        } else {
+            out << setw(8) << "-";
+        }
+        if (instructions > 0) {
+            out << setw(12) << setprecision(2) << 1000.0 * region.perCall(PerfEvent::LLCMisses) / instructions;
+        } else {
+            out << setw(12) << "-";
+        }
+        out << setprecision(1) << "\n";
+    }
+
+    out << "Totals:";
+    for (size_t r = 0; r < PERF_REGION_COUNT; ++r) {
+        PerfRegionStats region{stats(static_cast<PerfRegion>(r))};
+        if (region.calls == 0) continue;
+        out << "\n  " << REGION_NAMES[r] << ":";
+        for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+            if (available(static_cast<PerfEvent>(e))) out << " " << EVENT_NAMES[e] << " " << region.totals[e] << ";";
+        }
+    }
+    out << defaultfloat << "\n";
+}
@@ -0,0 +1,114 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Engine sections measured by PERF_REGION; the names live in PerfCounters.cpp.
+enum class PerfRegion : uint8_t {
+    ProcessNewOrder,
+    UpdateStatistics,
+    LoadOrders,
+    StreamOrders,
+    ProcessOrders,
+    Count
+};
+
+// TaskClock is the thread's CPU time in nanoseconds, a software event that opens even
+// where the PMU is hidden (containers, most VMs); the others are hardware counters.
+enum class PerfEvent : uint8_t {
+    TaskClock,
+    Cycles,
+    Instructions,
+    L1DMisses,
+    LLCMisses,
+    BranchMisses,
+    Count
+};
+
+const size_t PERF_REGION_COUNT{static_cast<size_t>(PerfRegion::Count)};
+const size_t PERF_EVENT_COUNT{static_cast<size_t>(PerfEvent::Count)};
+
+struct PerfSample {
+    uint64_t values[PERF_EVENT_COUNT]{};
+};
+
+// Counts are inclusive (a region nested in another also counts in the outer one) and
+// exclude the measured cost of reading the counters around each call.
+struct PerfRegionStats {
+    uint64_t calls{0};
+    uint64_t totals[PERF_EVENT_COUNT]{};
+
+    double perCall(PerfEvent event) const {
+        return calls ? static_cast<double>(totals[static_cast<size_t>(event)]) / calls : 0.0;
+    }
+};
+
+// User-space counters from Linux perf_event_open, one counter group per thread opened on
+// the thread's first measured region, read with one syscall at each region boundary. Off
+// until enable(); while off a region costs one relaxed load. Events the kernel or the
+// hardware refuses are left out and reported as unavailable.
+class PerfCounters {
+public:
+    static PerfCounters& instance();
+
+    // False (with the reason on cerr) when not even TaskClock can be opened: not Linux,
+    // perf_event_paranoid above 2, or a seccomp profile that blocks perf_event_open.
+    bool enable();
+    void disable() { active.store(false, std::memory_order_relaxed); }
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+    bool available(PerfEvent event) const { return (availableEvents & (1u << static_cast<unsigned>(event))) != 0; }
+    void reset();
+
+    // Summed over every thread that entered the region.
+    PerfRegionStats stats(PerfRegion region) const;
+    // Per-call averages and totals for every region entered, with IPC and miss rates.
+    void report(std::ostream& out) const;
+
+    bool begin(PerfSample& start);
+    void end(PerfRegion region, const PerfSample& start);
+
+private:
+    struct ThreadCounters;
+
+    PerfCounters() = default;
+
+    static std::atomic<bool> active;
+    uint32_t availableEvents{0};
+    // Smallest reading of an empty region per event, taken by enable().
+    uint64_t overhead[PERF_EVENT_COUNT]{};
+    mutable std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadCounters>> threads;
+
+    ThreadCounters* local();
+};
+
+class PerfScope {
+public:
+    explicit PerfScope(PerfRegion region) : region(region) {
+        if (PerfCounters::enabled()) measuring = PerfCounters::instance().begin(start);
+    }
+    ~PerfScope() {
+        if (measuring) PerfCounters::instance().end(region, start);
+    }
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    PerfRegion region;
+    bool measuring{false};
+    PerfSample start;
+};
+
+// Building with LOB_PERF_COUNTERS_DISABLED removes every region.
+#ifdef LOB_PERF_COUNTERS_DISABLED
+#define PERF_REGION(region) ((void)0)
+#else
+#define PERF_REGION(region) PerfScope perfScope##region{PerfRegion::region}
+#endif
+
+#endif
@@ -0,0 +1,380 @@
+#include "PipelineExecutor.h"
+#include "InputJournal.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+namespace {
+// Indexed by PipelineStage.
+const char* const STAGE_NAMES[]{"read", "parse", "route", "load", "uncross", "merge"};
+
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == PIPELINE_STAGE_COUNT, "every stage needs a name");
+
+uint64_t nanosSince(chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+}
+
+struct StageCounters {
+    atomic<uint64_t> tasks{0};
+    atomic<uint64_t> busyNanos{0};
+    atomic<uint64_t> blockedNanos{0};
+};
+
+// Backpressure from the books to the reader: a block holds a slot from the moment it is read
+// until the last of its orders is loaded.
+class BlockSlots {
+public:
+    explicit BlockSlots(size_t slots) : limit(max<size_t>(slots, 1)) {}
+
+    void acquire() {
+        unique_lock<mutex> lock(slotMutex);
+        freed.wait(lock, [this] { return inUse < limit; });
+        peak = max(peak, ++inUse);
+    }
+
+    void release() {
+        {
+            lock_guard<mutex> lock(slotMutex);
+            --inUse;
+        }
+        freed.notify_one();
+    }
+
+    size_t peakInUse() {
+        lock_guard<mutex> lock(slotMutex);
+        return peak;
+    }
+
+private:
+    mutex slotMutex;
+    condition_variable freed;
+    size_t limit;
+    size_t inUse{0};
+    size_t peak{0};
+};
+
+// Shared by the pieces of one block; the slot frees with the last of them.
+struct Slot {
+    BlockSlots& slots;
+
+    explicit Slot(BlockSlots& slots) : slots(slots) {}
+    ~Slot() { slots.release(); }
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+};
+
+struct Block {
+    vector<Order> orders;
+    shared_ptr<Slot> slot;
+    bool malformed{false};
+};
+
+// One asset's share of a block.
+struct Part {
+    vector<Order> orders;
+    shared_ptr<Slot> slot;
+};
+
+// An asset's books and its queue of parts; scheduled while a load task owns the books.
+struct Lane {
+    OrderBookManager book{""};
+    mutex laneMutex;
+    deque<Part> parts;
+    bool scheduled{false};
+    vector<Execution> executions;
+};
+
+class PipelineRun {
+public:
+    PipelineRun(WorkStealingPool& pool, OrderBookManager& target, const string& path, size_t slots)
+        : pool(pool), target(target), path(path), slots(slots), journal(target.getInputJournal()) {}
+
+    bool read(size_t blockBytes);
+    void uncross();
+    void merge();
+    bool isMalformed() const { return stopped.load(memory_order_relaxed); }
+    void fill(PipelineStats& stats);
+
+private:
+    WorkStealingPool& pool;
+    OrderBookManager& target;
+    const string& path;
+    BlockSlots slots;
+    InputJournal* journal;
+    StageCounters stages[PIPELINE_STAGE_COUNT];
+    atomic<bool> stopped{false};
+    uint64_t blocks{0};
+
+    // Router state.
+    mutex routeMutex;
+    map<uint64_t, Block> parsed;
+    uint64_t nextRoute{0};
+    uint64_t routed{0};
+    map<string, unique_ptr<Lane>> lanes;
+
+    StageCounters& stage(PipelineStage s) { return stages[static_cast<size_t>(s)]; }
+    void parse(uint64_t sequence, const string& text, shared_ptr<Slot> slot);
+    void route(uint64_t sequence, Block block);
+    map<string, unique_ptr<Lane>>::iterator laneFor(const string& asset);
+    void enqueue(Lane& lane, Part part);
+    void load(Lane& lane);
+};
+
+bool PipelineRun::read(size_t blockBytes) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        cerr << "Cannot open order file " << path << endl;
+        return false;
+    }
+    blockBytes = max<size_t>(blockBytes, 1);
+    StageCounters& reading{stage(PipelineStage::Read)};
+
+    // Rows never straddle blocks: whatever follows a block's last newline starts the next one.
+    string carry;
+    bool header{true};
+    bool last{false};
+    while (!last && !stopped.load(memory_order_relaxed)) {
+        auto start{chrono::steady_clock::now()};
+        string text{move(carry)};
+        carry.clear();
+        size_t kept{text.size()};
+        text.resize(kept + blockBytes);
+        file.read(&text[kept], static_cast<streamsize>(blockBytes));
+        text.resize(kept + static_cast<size_t>(file.gcount()));
+        last = !file;
+        if (!last) {
+            size_t end{text.rfind('\n')};
+            if (end == string::npos) {
+                carry = move(text);
+                continue;
+            }
+            carry.assign(text, end + 1, string::npos);
+            text.resize(end + 1);
+        }
+        if (header) {
+            size_t end{text.find('\n')};
+            text.erase(0, end == string::npos ? text.size() : end + 1);
+            header = false;
+        }
+        reading.busyNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+        reading.tasks.fetch_add(1, memory_order_relaxed);
+        if (text.empty()) continue;
+
+        start = chrono::steady_clock::now();
+        slots.acquire();
+        reading.blockedNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+        auto slot{make_shared<Slot>(slots)};
+        uint64_t sequence{blocks++};
+        pool.submit([this, sequence, text = move(text), slot = move(slot)]() mutable {
+            parse(sequence, text, move(slot));
+        });
+    }
+    pool.wait();
+    return true;
+}
+
+void PipelineRun::parse(uint64_t sequence, const string& text, shared_ptr<Slot> slot) {
+    auto start{chrono::steady_clock::now()};
+    Block block;
+    block.slot = move(slot);
+    block.orders.reserve(text.size() / 60 + 1);
+    string line;
+    for (size_t begin = 0; begin < text.size();) {
+        size_t end{text.find('\n', begin)};
+        if (end == string::npos) end = text.size();
+        line.assign(text, begin, end - begin);
+        begin = end + 1;
+        try {
+            block.orders.emplace_back();
+            OrderBookManager::parseOrder(line, block.orders.back());
+        } catch (const exception&) {
+            block.orders.pop_back();
+            cerr << "Stopped reading " << path << " at a malformed row: " << line << endl;
+            block.malformed = true;
+            break;
+        }
+    }
+    StageCounters& parsing{stage(PipelineStage::Parse)};
+    parsing.busyNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+    parsing.tasks.fetch_add(1, memory_order_relaxed);
+    route(sequence, move(block));
+}
+
+void PipelineRun::route(uint64_t sequence, Block block) {
+    StageCounters& routing{stage(PipelineStage::Route)};
+    auto start{chrono::steady_clock::now()};
+    lock_guard<mutex> lock(routeMutex);
+    routing.blockedNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+    start = chrono::steady_clock::now();
+
+    // Blocks finish parsing in any order; they leave here in file order, up to a malformed row.
+    parsed.emplace(sequence, move(block));
+    vector<pair<Lane*, Part>> split;
+    for (auto next{parsed.find(nextRoute)}; next != parsed.end(); next = parsed.find(++nextRoute)) {
+        Block ready{move(next->second)};
+        parsed.erase(next);
+        if (stopped.load(memory_order_relaxed)) continue;
+
+        // Rows of one asset tend to come in runs, so the part is only looked up on a change.
+        split.clear();
+        const string* asset{nullptr};
+        Part* part{nullptr};
+        for (auto& order : ready.orders) {
+            if (journal) journal->recordLoadedOrder(order);
+            if (!asset || order.asset != *asset) {
+                auto lane{laneFor(order.asset)};
+                asset = &lane->first;
+                auto it{find_if(split.begin(), split.end(),
+                                [&lane](const auto& entry) { return entry.first == lane->second.get(); })};
+                if (it == split.end()) it = split.insert(split.end(), {lane->second.get(), Part{{}, ready.slot}});
+                part = &it->second;
+            }
+            part->orders.push_back(move(order));
+        }
+        routed += ready.orders.size();
+        for (auto& [target, part] : split) enqueue(*target, move(part));
+        if (ready.malformed) stopped.store(true, memory_order_relaxed);
+        routing.tasks.fetch_add(1, memory_order_relaxed);
+    }
+    routing.busyNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+}
+
+map<string, unique_ptr<Lane>>::iterator PipelineRun::laneFor(const string& asset) {
+    auto it{lanes.find(asset)};
+    if (it == lanes.end()) {
+        it = lanes.emplace(asset, make_unique<Lane>()).first;
+        auto& lane{it->second};
+        Lane* owner{lane.get()};
+        // Each asset calls on top of what the target already holds for it.
+        lane->book.setAnalyticsConfig(target.getAnalyticsConfig());
+        lane->book.seedFrom(target, asset);
+        lane->book.setUncrossMode(UncrossMode::Auction);
+        lane->book.addExecutionListener([owner](const string&, const Execution& execution) {
+            owner->executions.push_back(execution);
+        });
+    }
+    return it;
+}
+
+void PipelineRun::enqueue(Lane& lane, Part part) {
+    {
+        lock_guard<mutex> lock(lane.laneMutex);
+        lane.parts.push_back(move(part));
+        if (lane.scheduled) return;
+        lane.scheduled = true;
+    }
+    pool.submit([this, &lane] { load(lane); });
+}
+
+void PipelineRun::load(Lane& lane) {
+    StageCounters& loading{stage(PipelineStage::Load)};
+    while (true) {
+        Part part;
+        {
+            lock_guard<mutex> lock(lane.laneMutex);
+            if (lane.parts.empty()) {
+                lane.scheduled = false;
+                return;
+            }
+            part = move(lane.parts.front());
+            lane.parts.pop_front();
+        }
+        auto start{chrono::steady_clock::now()};
+        for (const auto& order : part.orders) lane.book.callOrder(order);
+        loading.busyNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+        loading.tasks.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+void PipelineRun::uncross() {
+    StageCounters& uncrossing{stage(PipelineStage::Uncross)};
+    for (auto& [asset, lane] : lanes) {
+        pool.submit([&uncrossing, &lane = *lane] {
+            auto start{chrono::steady_clock::now()};
+            lane.book.uncrossCalled();
+            uncrossing.busyNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+            uncrossing.tasks.fetch_add(1, memory_order_relaxed);
+        });
+    }
+    pool.wait();
+}
+
+void PipelineRun::merge() {
+    StageCounters& merging{stage(PipelineStage::Merge)};
+    auto start{chrono::steady_clock::now()};
+    int64_t latest{target.getClock()};
+    for (auto& [asset, lane] : lanes) {
+        target.seedFrom(lane->book, asset);
+        for (const auto& execution : lane->executions) target.publishExecution(asset, execution);
+        latest = max(latest, lane->book.getClock());
+        merging.tasks.fetch_add(1, memory_order_relaxed);
+    }
+    // Replays as the same file loaded and processed in Auction mode.
+    if (journal && routed > 0) journal->recordUncross(UncrossMode::Auction);
+    target.advanceClock(latest);
+    merging.busyNanos.fetch_add(nanosSince(start), memory_order_relaxed);
+}
+
+void PipelineRun::fill(PipelineStats& stats) {
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i) {
+        stats.stages[i].tasks = stages[i].tasks.load(memory_order_relaxed);
+        stats.stages[i].busySeconds = stages[i].busyNanos.load(memory_order_relaxed) / 1e9;
+        stats.stages[i].blockedSeconds = stages[i].blockedNanos.load(memory_order_relaxed) / 1e9;
+    }
+    stats.orders = routed;
+    stats.blocks = blocks;
+    stats.assets = lanes.size();
+    stats.peakBlocks = slots.peakInUse();
+}
+}
+
+PipelineExecutor::PipelineExecutor(const PipelineConfig& config) : config(config), pool(config.threads) {}
+
+bool PipelineExecutor::run(const string& csvPath, OrderBookManager& manager) {
+    auto start{chrono::steady_clock::now()};
+    vector<uint64_t> stolenBefore;
+    for (size_t i = 0; i < pool.size(); ++i) stolenBefore.push_back(pool.getStats(i).stolen);
+
+    size_t maxBlocks{config.maxBlocks ? config.maxBlocks : 2 * pool.size() + 2};
+    PipelineRun pipeline(pool, manager, csvPath, maxBlocks);
+    bool opened{pipeline.read(config.blockBytes)};
+    if (opened) {
+        pipeline.uncross();
+        pipeline.merge();
+    }
+
+    stats = PipelineStats{};
+    pipeline.fill(stats);
+    stats.seconds = nanosSince(start) / 1e9;
+    stats.threads = pool.size();
+    for (size_t i = 0; i < pool.size(); ++i) stats.steals += pool.getStats(i).stolen - stolenBefore[i];
+    return opened && !pipeline.isMalformed();
+}
+
+void PipelineExecutor::report(ostream& out) const {
+    out << "Pipeline: " << stats.orders << " orders, " << stats.assets << " assets, " << stats.blocks
+        << " blocks in " << fixed << setprecision(3) << stats.seconds << " s on " << stats.threads << " threads";
+    if (stats.seconds > 0) out << " (" << static_cast<uint64_t>(stats.orders / stats.seconds) << " orders/s)";
+    out << "\n" << setw(10) << left << "STAGE" << right << setw(10) << "TASKS" << setw(12) << "BUSY s"
+        << setw(12) << "BLOCKED s" << setw(8) << "UTIL" << "\n";
+    for (size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i) {
+        const StageMetrics& stage{stats.stages[i]};
+        bool callingThread{i == static_cast<size_t>(PipelineStage::Read) ||
+                           i == static_cast<size_t>(PipelineStage::Merge)};
+        double capacity{stats.seconds * (callingThread ? 1.0 : static_cast<double>(stats.threads))};
+        out << setw(10) << left << STAGE_NAMES[i] << right << setw(10) << stage.tasks << setw(12)
+            << stage.busySeconds << setw(12) << stage.blockedSeconds << setw(7) << setprecision(1)
+            << (capacity > 0 ? 100.0 * stage.busySeconds / capacity : 0.0) << "%" << setprecision(3) << "\n";
+    }
+    out << "Peak " << stats.peakBlocks << " blocks in flight, " << stats.steals << " steals\n" << defaultfloat;
+}
@@ -0,0 +1,76 @@
+#ifndef PIPELINE_EXECUTOR_H
+#define PIPELINE_EXECUTOR_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "OrderBookManager.h"
+#include "WorkStealingPool.h"
+
+// Read and Merge run on the calling thread, the others as pool tasks.
+enum class PipelineStage : uint8_t {
+    Read,
+    Parse,
+    Route,
+    Load,
+    Uncross,
+    Merge,
+    Count
+};
+
+const size_t PIPELINE_STAGE_COUNT{static_cast<size_t>(PipelineStage::Count)};
+
+// threads 0: one per hardware thread. maxBlocks caps the blocks read but not yet entirely in
+// the books (0: two per thread, plus two); the reader waits for a slot once it is reached.
+struct PipelineConfig {
+    size_t threads{0};
+    size_t blockBytes{1 << 20};
+    size_t maxBlocks{0};
+};
+
+// blockedSeconds: Read waiting for a block slot, Route waiting for the router.
+struct StageMetrics {
+    uint64_t tasks{0};
+    double busySeconds{0.0};
+    double blockedSeconds{0.0};
+};
+
+struct PipelineStats {
+    StageMetrics stages[PIPELINE_STAGE_COUNT];
+    double seconds{0.0};
+    size_t threads{0};
+    uint64_t orders{0};
+    uint64_t blocks{0};
+    size_t assets{0};
+    size_t peakBlocks{0};
+    uint64_t steals{0};
+};
+
+// Loads an order file as one call phase with every core busy. The calling thread reads the
+// file in blocks cut at row ends; parse tasks turn blocks into orders; the router takes parsed
+// blocks back into file order, journals them and splits them by asset; one load task at a time
+// per asset puts its share into that asset's own OrderBookManager, so assets load in parallel
+// and each in file order. Once the file is in, every asset runs its auction as a task and the
+// results are merged into the target with seedFrom, its executions going to the target's
+// listeners. The target ends as after loading the file and processOrders in Auction mode, and
+// the input journal records exactly that. Continuous per-chunk matching stays on streamOrders.
+class PipelineExecutor {
+public:
+    explicit PipelineExecutor(const PipelineConfig& config = PipelineConfig{});
+
+    // False when the file cannot be opened or a row is malformed; rows before it are still
+    // loaded and uncrossed, as with streamOrders.
+    bool run(const std::string& csvPath, OrderBookManager& manager);
+    const PipelineStats& getStats() const { return stats; }
+    // Per-stage tasks, busy and blocked time, and utilization: the share of the pool for
+    // pool stages, of the calling thread for Read and Merge.
+    void report(std::ostream& out) const;
+
+private:
+    PipelineConfig config;
+    WorkStealingPool pool;
+    PipelineStats stats;
+};
+
+#endif
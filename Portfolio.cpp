@@ -1,40 +1,49 @@
 #include "Portfolio.h"
+#include "AsyncLogger.h"
 #include "OrderBookManager.h"
+#include "Journal.h"
+#include "OrderGenerator.h"
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <algorithm>
 
 
 using namespace std;
 
-Portfolio::Portfolio() : globalPnL(0.0) {
-    vector<string> intialStocks = {"AAPL", "TSLA", "GOOG", "MSFT", "AMZN", "META", "NFLX", "NVDA"};
-    for (const auto &stock : intialStocks) {
-        holdings[stock] = Holding{0.0, 0.0};
-    }
-}
+Portfolio::Portfolio() : ownedLedger(new Ledger(ASSETS.size())), ledger(ownedLedger.get()),
+    accountId(ownedLedger->addAccount(0.0)), journal(nullptr), historyLimit(0),
+    marketPrices(ASSETS.size(), 0.0) {}
+
+Portfolio::Portfolio(Ledger &sharedLedger, uint32_t id) : ledger(&sharedLedger), accountId(id),
+    journal(nullptr), historyLimit(0), marketPrices(min(sharedLedger.assetCount(), ASSETS.size()), 0.0) {}
 
 void Portfolio::updateBuy(const string &stock, double quantity, double price, const string &dateTime){
-    Holding &h = holdings[stock];
-    double totalCost = h.quantity*h.averagePrice + quantity*price;
-    h.quantity += quantity;
-    h.averagePrice = (h.quantity >0) ? totalCost/h.quantity : price;
+    int assetId = getAssetId(stock);
+    if (assetId < 0 || !ledger->isValid(accountId, assetId)){
+        LOB_LOG(LogLevel::Warning, LogFormat::BuyUnknownAsset, stock);
+        return;
+    }
+    ledger->addPosition(accountId, assetId, quantity, price);
 
     Trade trade = {dateTime, stock, "BUY", quantity, price, quantity*price};
     tradeHistory.push_back(trade); 
-    cout << "Updated portfolio with buy of " << quantity << " shares of " << stock << " at " << price << endl;
+    if (journal) {
+        journal->recordTrade(stock, trade.tradeType, quantity, price, dateTime);
+        if (tradeHistory.size() > historyLimit) tradeHistory.pop_front();
+    }
+    LOB_LOG(LogLevel::Info, LogFormat::BuyUpdated, quantity, stock, price);
 }
 
-void Portfolio::updateSell(const string & stock, double quantity, double price, const string &dateTime){
-    if (holdings.find(stock) == holdings.end() || holdings[stock].quantity < quantity){
-        cout << "Cannot sell " << quantity << " shares of " << stock << ". Insufficient quantity in portfolio." << endl;
-        return;
+bool Portfolio::updateSell(const string & stock, double quantity, double price, const string &dateTime){
+    int assetId = getAssetId(stock);
+    double realizedPnL = 0.0;
+    if (assetId < 0 || !ledger->isValid(accountId, assetId) ||
+        !ledger->reducePosition(accountId, assetId, quantity, price, realizedPnL)){
+        LOB_LOG(LogLevel::Warning, LogFormat::SellRejected, quantity, stock);
+        return false;
     }
-    Holding &h = holdings[stock];
-
-    double realizedPnL = (price - h.averagePrice)*quantity;
-    globalPnL += realizedPnL;
 
     PnLRecord pnlRecord = {dateTime, stock, realizedPnL, 0.0};
     pnlHistory.push_back(pnlRecord);
@@ -42,36 +51,110 @@ void Portfolio::updateSell(const string & stock, double quantity, double price,
     Trade trade = {dateTime, stock, "SELL", quantity, price, quantity*price};
     tradeHistory.push_back(trade);
 
-    cout << "Portfolio updated with sale of " << quantity << " shares of " << stock << " at " << price << endl;
-    cout << " Realized PnL: " << realizedPnL << endl;
+    if (journal) {
+        journal->recordPnL(stock, realizedPnL, pnlRecord.quantity, dateTime);
+        journal->recordTrade(stock, trade.tradeType, quantity, price, dateTime);
+        if (pnlHistory.size() > historyLimit) pnlHistory.pop_front();
+        if (tradeHistory.size() > historyLimit) tradeHistory.pop_front();
+    }
+
+    LOB_LOG(LogLevel::Info, LogFormat::SellUpdated, quantity, stock, price, realizedPnL);
+    return true;
+}
+
+void Portfolio::markToMarket(const string &stock, double price){
+    int assetId = getAssetId(stock);
+    if (assetId >= 0 && static_cast<size_t>(assetId) < marketPrices.size()){
+        marketPrices[assetId] = price;
+    }
+}
 
-    h.quantity -= quantity;
-    if (h.quantity <= 0){
-        holdings.erase(stock);
+void Portfolio::onStatisticsUpdate(const string &stock, const OrderBookStatistics &stats){
+    if (stats.midPrice > 0){
+        markToMarket(stock, stats.midPrice);
     }
 }
 
+double Portfolio::getRealizedPnL(const string &stock) const{
+    int assetId = getAssetId(stock);
+    return ledger->isValid(accountId, assetId) ? ledger->realizedPnL(accountId, assetId) : 0.0;
+}
+
+double Portfolio::getQuantity(const string &stock) const{
+    int assetId = getAssetId(stock);
+    return ledger->isValid(accountId, assetId) ? ledger->position(accountId, assetId) : 0.0;
+}
+
+Holding Portfolio::getHolding(const string &stock) const{
+    int assetId = getAssetId(stock);
+    return ledger->isValid(accountId, assetId) ? holdingAt(assetId) : Holding{};
+}
+
+Holding Portfolio::holdingAt(uint32_t assetId) const{
+    Holding h;
+    h.quantity = ledger->position(accountId, assetId);
+    h.averagePrice = ledger->averagePrice(accountId, assetId);
+    h.marketPrice = marketPrices[assetId];
+    h.hasMarketPrice = h.marketPrice > 0;
+    if (h.hasMarketPrice){
+        h.aum = h.quantity * h.marketPrice;
+        h.unrealizedPnL = (h.marketPrice - h.averagePrice) * h.quantity;
+    }
+    return h;
+}
+
+double Portfolio::getUnrealizedPnL() const{
+    double total = 0.0;
+    for (uint32_t i = 0; i < marketPrices.size(); ++i){
+        total += holdingAt(i).unrealizedPnL;
+    }
+    return total;
+}
+
+double Portfolio::getAUM() const{
+    double total = 0.0;
+    for (uint32_t i = 0; i < marketPrices.size(); ++i){
+        total += holdingAt(i).aum;
+    }
+    return total;
+}
+
 void Portfolio::printHoldings() const{
     cout << "\nPositions actuelles du portefeuille: " << endl;
-    if (holdings.empty()){
-        cout << "No position in portfolio." << endl;
-        return;
+    bool hasPosition = false;
+    for (uint32_t i = 0; i < marketPrices.size(); ++i){
+        double quantity = ledger->position(accountId, i);
+        if (quantity <= 0) continue;
+        hasPosition = true;
+        cout << "Stock" << ASSETS[i]
+            << ",Quantity: " << quantity
+            << ", Prix moyen $" << ledger->averagePrice(accountId, i) << endl;
     }
-
-    for (const auto &pair : holdings){
-        cout << "Stock" << pair.first
-            << ",Quantity: " << pair.second.quantity
-            << ", Prix moyen $" << pair.second.averagePrice << endl;
-        
+    if (!hasPosition){
+        cout << "No position in portfolio." << endl;
     }
 }
 
 void Portfolio::printGlobalPnL() const{
-    cout << "\nGlobal PnL: " << globalPnL << endl;
+    cout << "\nGlobal PnL: " << ledger->totalRealizedPnL(accountId) << endl;
 }
 
 
+void Portfolio::attachJournal(Journal *j, size_t tailSize){
+    journal = j;
+    historyLimit = tailSize;
+    while (tradeHistory.size() > historyLimit) tradeHistory.pop_front();
+    while (pnlHistory.size() > historyLimit) pnlHistory.pop_front();
+}
+
 void Portfolio::logTradesToCSV(const string &filename) const {
+    if (journal) {
+        journal->flush();
+        if (JournalReader(journal->getPath()).exportTradesCSV(filename)) {
+            cout << "Portfolio trades saved in the file " << filename << endl;
+        }
+        return;
+    }
     ofstream file(filename);
     if (!file.is_open()) {
         cerr << "Error: file access denied" << endl;
@@ -87,6 +170,13 @@ void Portfolio::logTradesToCSV(const string &filename) const {
 }
 
 void Portfolio::logPnLHistoryToCSV(const string &filename) const {
+    if (journal) {
+        journal->flush();
+        if (JournalReader(journal->getPath()).exportPnLCSV(filename)) {
+            cout << "Portfolio PnL history saved to " << filename << endl;
+        }
+        return;
+    }
     ofstream file(filename);
     if (!file.is_open()) {
         cerr << "Error opening portfolio PnL CSV file." << endl;
@@ -101,36 +191,25 @@ void Portfolio::logPnLHistoryToCSV(const string &filename) const {
     cout << "Portfolio PnL history saved to " << filename << endl;
 }
 
-void Portfolio::printAssetPerformance(const map<string, OrderBookStatistics>& marketStats) const {
+void Portfolio::printAssetPerformance() const {
     cout << "\nAsset Performance:" << endl;
 
-    for (const auto &pair : holdings) {
-        const string &stock = pair.first;
-        const Holding &h = pair.second;
-
-        if (marketStats.find(stock) != marketStats.end()) {
-            const OrderBookStatistics &stats = marketStats.at(stock);
-
-            double currentPrice = stats.midPrice;
-            double aum = h.quantity * currentPrice;
-            double unrealizedPnL = (currentPrice - h.averagePrice) * h.quantity;
- 
-            double assetRealizedPnL = 0.0;
-            for (const auto &record : pnlHistory) {
-                if (record.stock == stock) {
-                    assetRealizedPnL += record.realizedPnL;
-                }
-            }
-            double totalPnL = unrealizedPnL + assetRealizedPnL;
-            
+    for (uint32_t i = 0; i < marketPrices.size(); ++i) {
+        const string &stock = ASSETS[i];
+        const Holding h = holdingAt(i);
+        if (h.quantity <= 0) continue;
+
+        if (h.hasMarketPrice) {
+            double assetRealizedPnL = ledger->realizedPnL(accountId, i);
+            double totalPnL = h.unrealizedPnL + assetRealizedPnL;
+
             cout << "Stock: " << stock << endl;
             cout << "  Quantity: " << h.quantity << ", Average Price: $" << h.averagePrice << endl;
-            cout << "  Current Price: $" << currentPrice << ", AUM: $" << aum << endl;
-            cout << "  Unrealized PnL: $" << unrealizedPnL << ", Realized PnL: $" << assetRealizedPnL 
+            cout << "  Current Price: $" << h.marketPrice << ", AUM: $" << h.aum << endl;
+            cout << "  Unrealized PnL: $" << h.unrealizedPnL << ", Realized PnL: $" << assetRealizedPnL 
                  << ", Total PnL: $" << totalPnL << "\n" << endl;
         } else {
             cout << "No market data for " << stock << endl;
         }
     }
 }
-    
\ No newline at end of file
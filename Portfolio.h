@@ -4,8 +4,14 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <cstdint>
 
 #include "OrderBookManager.h"
+#include "Ledger.h"
+
+class Journal;
 
 struct Trade {
     std::string dateTime;
@@ -19,6 +25,10 @@ struct Trade {
 struct Holding{
     double quantity{0.0};
     double averagePrice{0.0};
+    double marketPrice{0.0};
+    double unrealizedPnL{0.0};
+    double aum{0.0};
+    bool hasMarketPrice{false};
 };
 
 struct PnLRecord{
@@ -28,13 +38,17 @@ struct PnLRecord{
     double quantity{0.0};
 };
 
+// View over one ledger account: positions, average prices and realized PnL live in the
+// Ledger; the portfolio adds marks, trade history and reporting on top.
 class Portfolio {
 public: 
     Portfolio();
 
+    Portfolio(Ledger &ledger, uint32_t accountId);
+
     void updateBuy(const std::string &stock, double quantity, double price, const std::string &dateTime);
 
-    void updateSell(const std::string &stock, double quantity, double price, const std::string &dateTime);
+    bool updateSell(const std::string &stock, double quantity, double price, const std::string &dateTime);
 
     void printHoldings() const;
 
@@ -44,14 +58,41 @@ public:
 
     void logPnLHistoryToCSV(const std::string &filename) const;
 
-    void printAssetPerformance(const std::map<std::string, OrderBookStatistics>& marketStats) const;
+    void printAssetPerformance() const;
 
-private:
+    // Revalues a holding at the given price; fed by OrderBookManager statistics updates.
+    void markToMarket(const std::string &stock, double price);
+
+    void onStatisticsUpdate(const std::string &stock, const OrderBookStatistics &stats);
+
+    double getRealizedPnL(const std::string &stock) const;
+
+    double getQuantity(const std::string &stock) const;
+
+    Holding getHolding(const std::string &stock) const;
 
-    std::map<std::string, Holding> holdings;
-    std::vector<Trade> tradeHistory;
-    double globalPnL;
-    std::vector<PnLRecord> pnlHistory;
+    double getUnrealizedPnL() const;
+
+    double getAUM() const;
+
+    Ledger &getLedger() const { return *ledger; }
+
+    uint32_t getAccountId() const { return accountId; }
+
+    // Persists every trade to the journal and keeps only the last tailSize records in memory.
+    void attachJournal(Journal *journal, size_t tailSize = 1024);
+
+private:
+    Holding holdingAt(uint32_t assetId) const;
+
+    std::unique_ptr<Ledger> ownedLedger;
+    Ledger *ledger;
+    uint32_t accountId;
+    std::deque<Trade> tradeHistory;
+    std::deque<PnLRecord> pnlHistory;
+    Journal *journal;
+    size_t historyLimit;
+    std::vector<double> marketPrices;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "ShardedSimulator.h"
+#include <limits>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+ShardedSimulator::ShardedSimulator(const OrderBookManager& source, size_t shardCount, bool pin, uint64_t seed)
+    : pinThreads(pin) {
+    shardCount = max<size_t>(shardCount, 1);
+    unsigned cpus{max(thread::hardware_concurrency(), 1u)};
+    random_device rd;
+
+    const auto& statistics{source.getStatistics()};
+    assetTotal = statistics.size();
+    for (size_t i = 0; i < shardCount; ++i) {
+        shards.push_back(make_unique<ShardContext>());
+        shards.back()->cpu = static_cast<int>(i % cpus);
+        shards.back()->assets.reserve(assetTotal / shardCount + 1);
+    }
+
+    size_t index{0};
+    for (const auto& [asset, stats] : statistics) {
+        ShardContext& shard{*shards[index % shardCount]};
+        AssetContext& context{shard.assets.emplace_back(&shard.memory.levels)};
+        context.assetId = index;
+        context.asset = asset;
+        context.stats = stats;
+        context.rng.seed(seed ? static_cast<uint32_t>(seed + index) : rd());
+
+        // Copied levels keep their ids, so new ones are numbered past the largest.
+        auto bid{source.getBidBooks().find(asset)};
+        if (bid != source.getBidBooks().end()) context.bids.insert(bid->second.begin(), bid->second.end());
+        auto ask{source.getAskBooks().find(asset)};
+        if (ask != source.getAskBooks().end()) context.asks.insert(ask->second.begin(), ask->second.end());
+        for (const auto& [price, entry] : context.bids) {
+            context.bidNotional += price * entry.quantity;
+            shard.levelSequence = max(shard.levelSequence, entry.levelId);
+            shard.nextOrderId = max(shard.nextOrderId, entry.id + 1);
+        }
+        for (const auto& [price, entry] : context.asks) {
+            context.askNotional += price * entry.quantity;
+            shard.levelSequence = max(shard.levelSequence, entry.levelId);
+            shard.nextOrderId = max(shard.nextOrderId, entry.id + 1);
+        }
+        ++index;
+    }
+}
+
+void ShardedSimulator::pinCurrentThread(int cpu) {
+#ifdef _WIN32
+    SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu);
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+void ShardedSimulator::runShard(ShardContext& shard, int ticks, int ordersPerAssetPerTick) {
+    uint64_t processed{0};
+
+    for (int tick = 0; tick < ticks; ++tick) {
+        auto now{chrono::system_clock::now()};
+        for (auto& context : shard.assets) {
+            for (int k = 0; k < ordersPerAssetPerTick; ++k) {
+                const OrderBookStatistics& stats{context.stats};
+                double minPrice{stats.bidPrice};
+                double maxPrice{stats.askPrice};
+                double midPrice{stats.midPrice};
+                // A shard that has used up its ids stops sending orders.
+                if (minPrice <= 0 || maxPrice <= 0 || midPrice <= 0 ||
+                    shard.nextOrderId == numeric_limits<int>::max()) break;
+
+                bool isBuy{context.buySellDist(context.rng)};
+                bool isMarket{context.marketLimitDist(context.rng)};
+                int id{shard.nextOrderId++};
+                double quantity{context.volumeDist(context.rng)};
+                double price;
+                if (isMarket) {
+                    price = isBuy ? maxPrice : minPrice;
+                    quantity *= 10;
+                } else {
+                    price = midPrice + context.priceNoise(context.rng);
+                    if (isBuy && price >= maxPrice) price = maxPrice;
+                    if (!isBuy && price <= minPrice) price = minPrice;
+                }
+                if (isBuy) {
+                    match<BuySide>(shard, context, id, price, quantity, now);
+                } else {
+                    match<SellSide>(shard, context, id, price, quantity, now);
+                }
+                ++processed;
+            }
+        }
+
+        double quantity{0.0};
+        double amount{0.0};
+        for (const auto& context : shard.assets) {
+            quantity += context.stats.totalTradedQuantity;
+            amount += context.stats.totalTradedAmount;
+        }
+        shard.metrics.ordersProcessed.store(processed, memory_order_relaxed);
+        shard.metrics.tradedQuantity.store(quantity, memory_order_relaxed);
+        shard.metrics.tradedAmount.store(amount, memory_order_relaxed);
+        shard.metrics.ticksCompleted.fetch_add(1, memory_order_release);
+    }
+}
+
+template <typename Side>
+void ShardedSimulator::match(ShardContext& shard, AssetContext& context, int id, double price, double quantity,
+                             chrono::system_clock::time_point dateTime) {
+    using Opposite = typename Side::Opposite;
+    auto& ownBook{Side::own(context.bids, context.asks)};
+    auto& book{Opposite::own(context.bids, context.asks)};
+    double& notional{Opposite::own(context.bidNotional, context.askNotional)};
+    OrderBookStatistics& stats{context.stats};
+
+    double remaining{sweep<Side>(book, price, quantity, [&](double execPrice, double execQuantity, int) {
+        stats.lastTradePrice = execPrice;
+        stats.totalTradedQuantity += execQuantity;
+        stats.totalTradedAmount += execPrice * execQuantity;
+        notional -= execPrice * execQuantity;
+    })};
+    if (remaining > 0) {
+        restAt(ownBook, id, price, remaining, dateTime, shard.levelSequence);
+        Side::own(context.bidNotional, context.askNotional) += price * remaining;
+    }
+    updateStatistics(context);
+}
+
+void ShardedSimulator::updateStatistics(AssetContext& context) {
+    OrderBookStatistics& stats{context.stats};
+    if (context.bids.empty()) context.bidNotional = 0.0;
+    if (context.asks.empty()) context.askNotional = 0.0;
+    stats.bidPrice = context.bids.empty() ? 0.0 : context.bids.begin()->first;
+    stats.askPrice = context.asks.empty() ? 0.0 : context.asks.begin()->first;
+    stats.bidDepth = static_cast<int>(context.bids.size());
+    stats.askDepth = static_cast<int>(context.asks.size());
+    stats.totalBidAmount = context.bidNotional;
+    stats.totalAskAmount = context.askNotional;
+
+    if (stats.totalTradedQuantity > 0) {
+        stats.averageExecutedPrice = stats.totalTradedAmount / stats.totalTradedQuantity;
+    }
+    if (stats.bidPrice > 0 && stats.askPrice > 0) {
+        stats.midPrice = (stats.bidPrice + stats.askPrice) / 2;
+        stats.bidAskSpread = stats.askPrice - stats.bidPrice;
+    }
+}
+
+void ShardedSimulator::run(int ticks, int ordersPerAssetPerTick) {
+    vector<thread> workers;
+    workers.reserve(shards.size());
+    for (auto& shard : shards) {
+        ShardContext* context{shard.get()};
+        bool pin{pinThreads};
+        workers.emplace_back([context, pin, ticks, ordersPerAssetPerTick]() {
+            if (pin) pinCurrentThread(context->cpu);
+            runShard(*context, ticks, ordersPerAssetPerTick);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ShardTotals ShardedSimulator::aggregate() const {
+    ShardTotals totals;
+    for (const auto& shard : shards) {
+        totals.ticksCompleted += shard->metrics.ticksCompleted.load(memory_order_acquire);
+        totals.ordersProcessed += shard->metrics.ordersProcessed.load(memory_order_relaxed);
+        totals.tradedQuantity += shard->metrics.tradedQuantity.load(memory_order_relaxed);
+        totals.tradedAmount += shard->metrics.tradedAmount.load(memory_order_relaxed);
+    }
+    return totals;
+}
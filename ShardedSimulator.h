@@ -0,0 +1,91 @@
+#ifndef SHARDED_SIMULATOR_H
+#define SHARDED_SIMULATOR_H
+
+#include "OrderBookManager.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// One asset owned by exactly one shard: its generator state, book and statistics side by side.
+// Levels come from the shard's pool; the notionals are the resting price * quantity per side.
+struct AssetContext {
+    size_t assetId{0};
+    std::string asset;
+    BidBook bids;
+    AskBook asks;
+    double bidNotional{0.0};
+    double askNotional{0.0};
+    OrderBookStatistics stats;
+    std::mt19937 rng;
+    std::uniform_real_distribution<> volumeDist{0.1, 1000.0};
+    std::bernoulli_distribution marketLimitDist{0.5};
+    std::bernoulli_distribution buySellDist{0.5};
+    std::normal_distribution<> priceNoise{0.0, 3.0};
+
+    explicit AssetContext(std::pmr::memory_resource* memory) : bids(memory), asks(memory) {}
+};
+
+// Written only by the owning worker; read by other threads for aggregate reporting.
+struct alignas(64) ShardMetrics {
+    std::atomic<uint64_t> ordersProcessed{0};
+    std::atomic<uint64_t> ticksCompleted{0};
+    std::atomic<double> tradedQuantity{0.0};
+    std::atomic<double> tradedAmount{0.0};
+};
+
+// Everything a worker touches on the hot path. Declared before the assets so the pool outlives
+// their levels.
+struct ShardContext {
+    int cpu{-1};
+    BookMemory memory;
+    uint64_t levelSequence{0};
+    // Order ids only need to be unique within the shard; they start past the copied levels' ids.
+    int nextOrderId{1};
+    std::vector<AssetContext> assets;
+    ShardMetrics metrics;
+};
+
+struct ShardTotals {
+    uint64_t ordersProcessed{0};
+    uint64_t ticksCompleted{0};
+    double tradedQuantity{0.0};
+    double tradedAmount{0.0};
+};
+
+// Splits the assets of a seeded OrderBookManager across worker threads. Asset ids follow the
+// source's asset order and go round-robin: shard id % shardCount, slot id / shardCount. Each
+// worker owns its shard outright (no locks, no shared maps); only ShardMetrics are read across
+// threads. Shards match through the engine's kernel (sweep and restAt in MatchingKernel.h), but
+// keep only the book-side statistics and trade totals, not the rolling analytics, stops or expiry.
+class ShardedSimulator {
+public:
+    ShardedSimulator(const OrderBookManager& source, size_t shardCount, bool pinThreads = false,
+                     uint64_t seed = 0);
+
+    void run(int ticks, int ordersPerAssetPerTick = 1);
+    ShardTotals aggregate() const;
+
+    size_t shardCount() const { return shards.size(); }
+    size_t assetCount() const { return assetTotal; }
+    // Read once run has returned.
+    const AssetContext& assetContext(size_t assetId) const {
+        return shards[assetId % shards.size()]->assets[assetId / shards.size()];
+    }
+
+private:
+    std::vector<std::unique_ptr<ShardContext>> shards;
+    size_t assetTotal{0};
+    bool pinThreads;
+
+    static void runShard(ShardContext& shard, int ticks, int ordersPerAssetPerTick);
+    template <typename Side>
+    static void match(ShardContext& shard, AssetContext& context, int id, double price, double quantity,
+                      std::chrono::system_clock::time_point dateTime);
+    static void updateStatistics(AssetContext& context);
+    static void pinCurrentThread(int cpu);
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+using namespace std;
+
+TimerWheel::TimerWheel(int64_t tick) : tickNanos(max<int64_t>(tick, 1)), slots(LEVELS * SLOTS, NIL) {}
+
+TimerHandle TimerWheel::schedule(int64_t expiryNanos, uint64_t payload) {
+    uint32_t index;
+    if (freeList != NIL) {
+        index = freeList;
+        freeList = nodes[index].next;
+    } else {
+        index = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(Node{});
+    }
+    Node& node{nodes[index]};
+    int64_t expiry{expiryNanos / tickNanos + (expiryNanos % tickNanos > 0 ? 1 : 0)};
+    node.expiry = max(expiry, currentTick + 1);
+    node.payload = payload;
+    insert(index);
+    ++active;
+    return TimerHandle{index, node.generation};
+}
+
+bool TimerWheel::cancel(TimerHandle handle) {
+    if (handle.index >= nodes.size()) return false;
+    Node& node{nodes[handle.index]};
+    if (node.generation != handle.generation || node.slot == NIL) return false;
+    unlink(handle.index);
+    release(handle.index);
+    return true;
+}
+
+void TimerWheel::advance(int64_t nowNanos, vector<uint64_t>& expired) {
+    int64_t target{nowNanos / tickNanos};
+    while (currentTick < target) {
+        if (active == 0) {
+            currentTick = target;
+            break;
+        }
+
+        // Nothing can fire before the next boundary of the lowest occupied level.
+        int lowest{0};
+        while (levelCounts[lowest] == 0) ++lowest;
+        if (lowest > 0) {
+            int64_t span{int64_t{1} << (SLOT_BITS * lowest)};
+            currentTick = min(target, (currentTick / span + 1) * span - 1);
+            if (currentTick == target) break;
+        }
+
+        ++currentTick;
+        for (int level = LEVELS - 1; level > 0; --level) {
+            if ((currentTick & ((int64_t{1} << (SLOT_BITS * level)) - 1)) == 0) cascade(level);
+        }
+
+        uint32_t slot{static_cast<uint32_t>(currentTick & (SLOTS - 1))};
+        uint32_t index{slots[slot]};
+        slots[slot] = NIL;
+        while (index != NIL) {
+            uint32_t next{nodes[index].next};
+            --levelCounts[0];
+            expired.push_back(nodes[index].payload);
+            release(index);
+            index = next;
+        }
+    }
+}
+
+void TimerWheel::clear() {
+    nodes.clear();
+    freeList = NIL;
+    fill(slots.begin(), slots.end(), NIL);
+    fill(begin(levelCounts), end(levelCounts), 0);
+    active = 0;
+}
+
+void TimerWheel::insert(uint32_t index) {
+    Node& node{nodes[index]};
+    int64_t delta{max<int64_t>(node.expiry - currentTick, 0)};
+    int level{0};
+    while (level < LEVELS - 1 && delta >= (int64_t{1} << (SLOT_BITS * (level + 1)))) ++level;
+    // Beyond the top level the timer waits one rotation and is placed again when cascaded.
+    int64_t slotTick{currentTick + min<int64_t>(delta, (int64_t{1} << (SLOT_BITS * LEVELS)) - 1)};
+    uint32_t slot{static_cast<uint32_t>(level * SLOTS + ((slotTick >> (SLOT_BITS * level)) & (SLOTS - 1)))};
+
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = slots[slot];
+    if (node.next != NIL) nodes[node.next].prev = index;
+    slots[slot] = index;
+    ++levelCounts[level];
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node{nodes[index]};
+    if (node.prev != NIL) {
+        nodes[node.prev].next = node.next;
+    } else {
+        slots[node.slot] = node.next;
+    }
+    if (node.next != NIL) nodes[node.next].prev = node.prev;
+    --levelCounts[node.slot / SLOTS];
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node& node{nodes[index]};
+    ++node.generation;
+    node.slot = NIL;
+    node.next = freeList;
+    freeList = index;
+    --active;
+}
+
+void TimerWheel::cascade(int level) {
+    uint32_t slot{static_cast<uint32_t>(level * SLOTS + ((currentTick >> (SLOT_BITS * level)) & (SLOTS - 1)))};
+    uint32_t index{slots[slot]};
+    slots[slot] = NIL;
+    while (index != NIL) {
+        uint32_t next{nodes[index].next};
+        --levelCounts[level];
+        insert(index);
+        index = next;
+    }
+}
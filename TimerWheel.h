@@ -0,0 +1,67 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Names a scheduled timer. The generation makes a handle to an already fired or cancelled
+// timer harmless once its node has been reused.
+struct TimerHandle {
+    uint32_t index{UINT32_MAX};
+    uint32_t generation{0};
+};
+
+// Hierarchical timing wheel: four levels of 256 slots over ticks of tickNanos, so with the
+// default 1 ms tick level 0 spans 256 ms, level 1 about 65 s, level 2 about 4.6 h and
+// level 3 about 49 days (later timers go round the top level again). Nodes come from a
+// pooled free list and sit in intrusive doubly-linked slot lists, so schedule and cancel
+// are O(1). A timer fires on the first advance whose time reaches its expiry, rounded up
+// to a whole tick; advance jumps over spans in which the lower levels are empty.
+class TimerWheel {
+public:
+    explicit TimerWheel(int64_t tickNanos = 1000000);
+
+    // Expiries at or before the current time fire on the next advance.
+    TimerHandle schedule(int64_t expiryNanos, uint64_t payload);
+    // False when the timer already fired or was cancelled.
+    bool cancel(TimerHandle handle);
+    // Moves the clock to nowNanos (never backwards) and appends the payload of every
+    // timer due by then, in expiry order.
+    void advance(int64_t nowNanos, std::vector<uint64_t>& expired);
+
+    int64_t now() const { return currentTick * tickNanos; }
+    size_t size() const { return active; }
+    bool empty() const { return active == 0; }
+    void clear();
+
+private:
+    static constexpr int LEVELS{4};
+    static constexpr int SLOT_BITS{8};
+    static constexpr int SLOTS{1 << SLOT_BITS};
+    static constexpr uint32_t NIL{UINT32_MAX};
+
+    struct Node {
+        int64_t expiry;
+        uint64_t payload;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t generation;
+        uint32_t slot;
+    };
+
+    int64_t tickNanos;
+    int64_t currentTick{0};
+    size_t active{0};
+    std::vector<Node> nodes;
+    uint32_t freeList{NIL};
+    std::vector<uint32_t> slots;
+    size_t levelCounts[LEVELS]{};
+
+    void insert(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(int level);
+};
+
+#endif
@@ -1,4 +1,6 @@
 #include "TransactionResolver.h"
+#include "OrderGenerator.h"
+#include "AsyncLogger.h"
 #include <iostream>
 #include <ctime>
 #include <cstdio> 
@@ -17,26 +19,123 @@ string getCurrentDateTime(){
 return string(buffer);
 }
 
-void processBuyOrder(BankAccount &account, Portfolio &portfolio,
+bool processBuyOrder(BankAccount &account, Portfolio &portfolio,
                     const string &stock, double quantity, double price){
     
     string dateTime = getCurrentDateTime();
     double totalCose = quantity * price;;
 
     if (!account.withdraw(totalCose, dateTime)){
-        cout << "Order not processed. Insufficient funds." << endl;
-        return;
+        LOB_LOG(LogLevel::Warning, LogFormat::BuyNotProcessed);
+        return false;
     }
 
     portfolio.updateBuy(stock, quantity, price, dateTime);
+    return true;
 }
 
-void processSellOrder(BankAccount &account, Portfolio &portfolio,
+bool processSellOrder(BankAccount &account, Portfolio &portfolio,
         const std::string &stock, double quantity, double price) {
     
     string dateTime = getCurrentDateTime();
-    portfolio.updateSell(stock, quantity, price, dateTime);
+    if (!portfolio.updateSell(stock, quantity, price, dateTime)) {
+        return false;
+    }
     double totalAmount = quantity * price;
 
     account.deposit(totalAmount, dateTime);
-}
\ No newline at end of file
+    return true;
+}
+
+const char* riskResultToString(RiskResult result) {
+    switch (result) {
+        case RiskResult::Accepted: return "accepted";
+        case RiskResult::UnknownAsset: return "unknown asset";
+        case RiskResult::InvalidOrder: return "invalid price or quantity";
+        case RiskResult::OrderNotionalLimit: return "order notional limit exceeded";
+        case RiskResult::AccountNotionalLimit: return "account notional limit exceeded";
+        case RiskResult::InsufficientFunds: return "insufficient funds";
+        case RiskResult::PositionLimit: return "position limit exceeded";
+        case RiskResult::InsufficientPosition: return "insufficient position";
+        case RiskResult::PriceCollar: return "price outside collar";
+        case RiskResult::RateLimit: return "order rate limit exceeded";
+    }
+    return "unknown";
+}
+
+PreTradeRisk::PreTradeRisk(const BankAccount &acc, double maxNotional, const RiskLimits &defaultLimits)
+    : account(acc), slots(ASSETS.size()), limits(ASSETS.size()), accountNotional(0.0),
+      maxAccountNotional(maxNotional) {
+    for (size_t i = 0; i < ASSETS.size(); ++i) {
+        setLimits(static_cast<int>(i), defaultLimits);
+    }
+}
+
+void PreTradeRisk::setLimits(int assetId, const RiskLimits &assetLimits) {
+    if (assetId < 0 || assetId >= static_cast<int>(slots.size())) return;
+    RiskSlot &slot = slots[assetId];
+    limits[assetId] = assetLimits;
+    slot.maxPosition = assetLimits.maxPosition;
+    slot.maxOrderNotional = assetLimits.maxOrderNotional;
+    slot.maxOrdersPerWindow = assetLimits.maxOrdersPerSecond;
+    if (slot.markPrice > 0) {
+        slot.lowerCollar = slot.markPrice * (1.0 - assetLimits.collarPercent);
+        slot.upperCollar = slot.markPrice * (1.0 + assetLimits.collarPercent);
+    }
+}
+
+void PreTradeRisk::setPosition(int assetId, double quantity) {
+    if (assetId < 0 || assetId >= static_cast<int>(slots.size())) return;
+    RiskSlot &slot = slots[assetId];
+    accountNotional += (quantity - slot.position) * slot.markPrice;
+    slot.position = quantity;
+}
+
+void PreTradeRisk::onStatisticsUpdate(const string &asset, const OrderBookStatistics &stats) {
+    int assetId = getAssetId(asset);
+    if (assetId < 0 || stats.midPrice <= 0) return;
+    RiskSlot &slot = slots[assetId];
+    accountNotional += slot.position * (stats.midPrice - slot.markPrice);
+    slot.markPrice = stats.midPrice;
+    slot.lowerCollar = stats.midPrice * (1.0 - limits[assetId].collarPercent);
+    slot.upperCollar = stats.midPrice * (1.0 + limits[assetId].collarPercent);
+}
+
+void PreTradeRisk::onFill(int assetId, bool isBuy, double quantity, double price) {
+    if (assetId < 0 || assetId >= static_cast<int>(slots.size())) return;
+    RiskSlot &slot = slots[assetId];
+    if (slot.markPrice <= 0) {
+        slot.markPrice = price;
+    }
+    double signedQuantity = isBuy ? quantity : -quantity;
+    slot.position += signedQuantity;
+    accountNotional += signedQuantity * slot.markPrice;
+}
+
+RiskResult PreTradeRisk::check(int assetId, bool isBuy, double price, double quantity, int64_t nowNanos) {
+    if (assetId < 0 || assetId >= static_cast<int>(slots.size())) return RiskResult::UnknownAsset;
+    if (!(price > 0) || !(quantity > 0)) return RiskResult::InvalidOrder;
+
+    RiskSlot &slot = slots[assetId];
+    double notional = price * quantity;
+    if (notional > slot.maxOrderNotional) return RiskResult::OrderNotionalLimit;
+    if (slot.upperCollar > 0 && (price < slot.lowerCollar || price > slot.upperCollar)) {
+        return RiskResult::PriceCollar;
+    }
+
+    if (isBuy) {
+        if (notional > account.getBalance()) return RiskResult::InsufficientFunds;
+        if (slot.position + quantity > slot.maxPosition) return RiskResult::PositionLimit;
+        if (accountNotional + notional > maxAccountNotional) return RiskResult::AccountNotionalLimit;
+    } else if (quantity > slot.position) {
+        return RiskResult::InsufficientPosition;
+    }
+
+    if (nowNanos - slot.windowStart >= 1000000000) {
+        slot.windowStart = nowNanos;
+        slot.ordersInWindow = 0;
+    }
+    if (slot.ordersInWindow >= slot.maxOrdersPerWindow) return RiskResult::RateLimit;
+    ++slot.ordersInWindow;
+    return RiskResult::Accepted;
+}
@@ -2,15 +2,79 @@
 #define TRANSACTION_RESOLVER_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
 #include "BankAccount.h"
 #include "Portfolio.h"
 
 std::string getCurrentDateTime();
 
-void processBuyOrder(BankAccount &account, Portfolio &portfolio,
+bool processBuyOrder(BankAccount &account, Portfolio &portfolio,
                      const std::string &stock, double quantity, double price);
 
-void processSellOrder(BankAccount &account, Portfolio &portfolio,
+bool processSellOrder(BankAccount &account, Portfolio &portfolio,
                       const std::string &stock, double quantity, double price);
 
-#endif
\ No newline at end of file
+enum class RiskResult {
+    Accepted,
+    UnknownAsset,
+    InvalidOrder,
+    OrderNotionalLimit,
+    AccountNotionalLimit,
+    InsufficientFunds,
+    PositionLimit,
+    InsufficientPosition,
+    PriceCollar,
+    RateLimit
+};
+
+const char* riskResultToString(RiskResult result);
+
+struct RiskLimits {
+    double maxOrderNotional{50000.0};
+    double maxPosition{10000.0};
+    double collarPercent{0.05};
+    uint32_t maxOrdersPerSecond{20};
+};
+
+// Everything the check needs for one asset, precomputed and packed into one cache line.
+struct alignas(64) RiskSlot {
+    double lowerCollar{0.0};
+    double upperCollar{0.0};
+    double position{0.0};
+    double maxPosition{0.0};
+    double maxOrderNotional{0.0};
+    double markPrice{0.0};
+    int64_t windowStart{0};
+    uint32_t ordersInWindow{0};
+    uint32_t maxOrdersPerWindow{0};
+};
+
+static_assert(sizeof(RiskSlot) == 64, "RiskSlot must fit in a single cache line");
+
+// Pre-trade gate run before an order reaches the book. Limits and exposures are kept
+// in per-asset slots indexed by asset id, and collars are refreshed from book statistics,
+// so check() is a handful of loads and compares.
+class PreTradeRisk {
+public:
+    PreTradeRisk(const BankAccount &account, double maxAccountNotional = 250000.0,
+                 const RiskLimits &defaultLimits = RiskLimits());
+
+    void setLimits(int assetId, const RiskLimits &limits);
+    void setPosition(int assetId, double quantity);
+    void onStatisticsUpdate(const std::string &asset, const OrderBookStatistics &stats);
+    void onFill(int assetId, bool isBuy, double quantity, double price);
+
+    RiskResult check(int assetId, bool isBuy, double price, double quantity, int64_t nowNanos);
+
+    double getAccountNotional() const { return accountNotional; }
+
+private:
+    const BankAccount &account;
+    std::vector<RiskSlot> slots;
+    std::vector<RiskLimits> limits;
+    double accountNotional;
+    double maxAccountNotional;
+};
+
+#endif
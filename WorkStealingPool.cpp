@@ -0,0 +1,116 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+// Set on pool threads so submit can find the caller's own deque.
+thread_local WorkStealingPool* currentPool{nullptr};
+thread_local size_t currentWorker{0};
+}
+
+WorkStealingPool::WorkStealingPool(size_t threadCount) {
+    if (threadCount == 0) threadCount = max(thread::hardware_concurrency(), 1u);
+    for (size_t i = 0; i < threadCount; ++i) workers.push_back(make_unique<Worker>());
+    for (size_t i = 0; i < threadCount; ++i) threads.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    work.notify_all();
+    for (auto& worker : threads) worker.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t index{currentPool == this ? currentWorker : nextWorker.fetch_add(1, memory_order_relaxed) % workers.size()};
+    // Counted first, so the task cannot finish before it is counted; a worker woken early just
+    // looks again.
+    {
+        lock_guard<mutex> lock(stateMutex);
+        ++unfinished;
+        queued.fetch_add(1, memory_order_relaxed);
+    }
+    {
+        lock_guard<mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(move(task));
+    }
+    work.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    unique_lock<mutex> lock(stateMutex);
+    finished.wait(lock, [this] { return unfinished == 0; });
+}
+
+WorkerStats WorkStealingPool::getStats(size_t worker) const {
+    const Worker& w{*workers[worker]};
+    return WorkerStats{w.executed.load(memory_order_relaxed), w.stolen.load(memory_order_relaxed),
+                       w.busyNanos.load(memory_order_relaxed) / 1e9};
+}
+
+bool WorkStealingPool::take(size_t index, Task& task) {
+    {
+        Worker& own{*workers[index]};
+        lock_guard<mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers.size(); ++i) {
+        Worker& victim{*workers[(index + i) % workers.size()]};
+        lock_guard<mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = move(victim.tasks.front());
+        victim.tasks.pop_front();
+        queued.fetch_sub(1, memory_order_relaxed);
+        workers[index]->stolen.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+    Worker& self{*workers[index]};
+    Task task;
+    while (true) {
+        if (!take(index, task)) {
+            unique_lock<mutex> lock(stateMutex);
+            work.wait(lock, [this] { return stopping || queued.load(memory_order_relaxed) > 0; });
+            if (stopping && queued.load(memory_order_relaxed) == 0) return;
+            lock.unlock();
+            // A task counted but not pushed yet: let its submitter run.
+            this_thread::yield();
+            continue;
+        }
+
+        auto start{chrono::steady_clock::now()};
+        try {
+            task();
+        } catch (const exception& e) {
+            cerr << "Pool task failed: " << e.what() << endl;
+        }
+        task = nullptr;
+        auto nanos{chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()};
+        self.busyNanos.fetch_add(static_cast<uint64_t>(nanos), memory_order_relaxed);
+        self.executed.fetch_add(1, memory_order_relaxed);
+
+        bool idle;
+        {
+            lock_guard<mutex> lock(stateMutex);
+            idle = --unfinished == 0;
+        }
+        if (idle) finished.notify_all();
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WorkerStats {
+    uint64_t executed{0};
+    // Tasks this worker took from another worker's deque.
+    uint64_t stolen{0};
+    double busySeconds{0.0};
+};
+
+// Fixed set of workers, each with its own deque. A worker runs its newest task first (what it
+// just submitted is still in cache) and, when its deque is empty, steals the oldest task of
+// the others in turn; only a worker with nothing anywhere sleeps. Tasks submitted from outside
+// the pool are spread round robin.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // threads 0: one per hardware thread.
+    explicit WorkStealingPool(size_t threads = 0);
+    // Runs every task already submitted before the workers stop.
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(Task task);
+    // Returns once every submitted task, including those submitted by tasks, has run. Must not
+    // be called from a task.
+    void wait();
+    size_t size() const { return workers.size(); }
+    WorkerStats getStats(size_t worker) const;
+
+private:
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<uint64_t> busyNanos{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    // queued counts tasks submitted but not yet taken, unfinished those not yet done; both
+    // grow under stateMutex so a sleeping worker or wait() cannot miss them.
+    std::mutex stateMutex;
+    std::condition_variable work;
+    std::condition_variable finished;
+    std::atomic<size_t> queued{0};
+    size_t unfinished{0};
+    bool stopping{false};
+    std::atomic<size_t> nextWorker{0};
+
+    void run(size_t index);
+    bool take(size_t index, Task& task);
+};
+
+#endif
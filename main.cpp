@@ -17,6 +17,17 @@
 #include "Portfolio.h"
 #include "TransactionResolver.h"
 #include "OrderInputHandler.h"
+#include "Journal.h"
+#include "Checkpoint.h"
+#include "InputJournal.h"
+#include "BarAggregator.h"
+#include "MonteCarloRisk.h"
+#include "MarketDataPublisher.h"
+#include "OrderGateway.h"
+#include "PerfCounters.h"
+#include "PipelineExecutor.h"
+#include "ParameterSweep.h"
+#include "ShardedSimulator.h"
 
 // Utiliser le namespace std
 using namespace std;
@@ -25,6 +36,12 @@ using namespace std;
 BankAccount* g_userAccount  = nullptr;
 Portfolio*   g_userPortfolio= nullptr;
 OrderBookManager* g_manager = nullptr;
+Journal*     g_journal      = nullptr;
+
+const string CHECKPOINT_PATH = "lob_checkpoint.bin";
+const string INPUT_JOURNAL_PATH = "lob_input.bin";
+InputJournal* g_inputJournal = nullptr;
+BarAggregator* g_bars = nullptr;
 
 // Global mutex to protect console output from multiple threads
 mutex g_consoleMutex;
@@ -42,10 +59,15 @@ BOOL WINAPI ConsoleHandler(DWORD dwCtrlType) {
                     lock_guard<mutex> lock(g_consoleMutex);
                     cout << "Closing... Saving final logs.\n";
                 }
+                lock_guard<mutex> engine(g_manager->getEngineMutex());
                 g_userAccount->logTransactionsToCSV("bank_transactions.csv");
                 g_userPortfolio->logTradesToCSV("portfolio_trades.csv");
                 g_userPortfolio->logPnLHistoryToCSV("portfolio_pnl.csv");
                 g_manager->saveOrderBooks("output");
+                saveCheckpoint(CHECKPOINT_PATH, *g_manager, *g_userPortfolio, *g_userAccount,
+                               g_journal ? g_journal->size() : 0);
+                if (g_inputJournal) g_inputJournal->flush();
+                if (g_bars) g_bars->exportCSV("bars.csv");
             }
             Sleep(2000); // give time for file writes
             return TRUE;
@@ -54,21 +76,163 @@ BOOL WINAPI ConsoleHandler(DWORD dwCtrlType) {
     }
 }
 
-int main() {
-    // 1) Generate initial orders
-    int nbAssets = 3;
-    vector<int>    nbOrders     {100, 150, 200};
-    vector<double> prices       {150.0, 650.0, 300.0};
-    vector<double> shortRatios  {0.1,  0.2,  0.15};
+// Replays a recorded input journal into a fresh engine and checks the sealed digest.
+// With counters, the engine regions are measured and reported after the throughput.
+int runReplay(const string& path, bool paced, bool counters) {
+    InputJournalReader reader(path);
+    if (!reader.isOpen()) {
+        cerr << "Error: unable to open input journal " << path << endl;
+        return 1;
+    }
+    OrderBookManager replayed("");
+    if (counters) counters = PerfCounters::instance().enable();
+    ReplayResult result = reader.replay(replayed, paced ? ReplayPacing::Recorded : ReplayPacing::MaxSpeed);
 
-    string csvPath = "transactions.csv";
-    generateOrdersAndReturn(nbAssets, nbOrders, prices, shortRatios, csvPath);
+    cout << "Replayed " << result.records << " records (" << result.orders << " orders) in "
+         << result.seconds << " s";
+    if (result.seconds > 0) cout << " (" << static_cast<uint64_t>(result.records / result.seconds) << " records/s)";
+    cout << "\n";
+    if (counters) PerfCounters::instance().report(cout);
+    if (!result.verified) {
+        cout << "Journal was not sealed at a replayed offset; state digest " << hex << result.digest << dec << "\n";
+        return 0;
+    }
+    cout << (result.matched ? "Books and statistics match the recorded session\n"
+                            : "MISMATCH: books or statistics differ from the recorded session\n");
+    return result.matched ? 0 : 2;
+}
+
+// Backtests the default 1000-setting market-making grid against a recorded input journal and
+// prints the best rows.
+int runSweep(const string& path, size_t threads) {
+    vector<StrategyParams> configs = ParameterSweep::grid({0.0005, 0.001, 0.002, 0.005, 0.01}, {1.0, 5.0, 10.0, 50.0},
+                                                          {10.0, 50.0, 100.0, 500.0, 1000.0},
+                                                          {0.0, 0.001, 0.002, 0.005, 0.01}, {0.0, 60.0});
+    ParameterSweep sweep(threads);
+    if (!sweep.run(path, configs)) return 1;
+    sweep.report(cout, 20);
+    return 0;
+}
+
+// Opens a book for every known asset from a generated order file, then runs the sharded
+// simulator over them for a number of ticks and prints the throughput and each asset's book.
+int runSharded(size_t shards, int ticks, bool pin) {
+    const string path = "sharded_orders.csv";
+    vector<int> nbOrders(ASSETS.size(), 200);
+    vector<double> prices {150.0, 250.0, 650.0, 300.0, 180.0, 450.0, 600.0, 800.0};
+    generateOrdersAndReturn(static_cast<int>(ASSETS.size()), nbOrders, prices, {0.1}, path);
+    OrderBookManager seeded(path);
+    try {
+        seeded.loadOrders();
+        seeded.processOrders();
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
 
-    // 2) Create OrderBookManager and load the newly generated orders
+    ShardedSimulator simulator(seeded, shards, pin);
+    auto start = chrono::steady_clock::now();
+    simulator.run(ticks, 100);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    ShardTotals totals = simulator.aggregate();
+    cout << simulator.assetCount() << " assets on " << simulator.shardCount() << " shards: "
+         << totals.ordersProcessed << " orders in " << seconds << " s";
+    if (seconds > 0) cout << " (" << static_cast<uint64_t>(totals.ordersProcessed / seconds) << " orders/s)";
+    cout << ", traded " << totals.tradedQuantity << " for " << totals.tradedAmount << "\n";
+    for (size_t id = 0; id < simulator.assetCount(); ++id) {
+        const AssetContext& context = simulator.assetContext(id);
+        cout << setw(6) << left << context.asset << right << " bid " << setw(10) << context.stats.bidPrice
+             << " ask " << setw(10) << context.stats.askPrice << " levels " << setw(6)
+             << context.stats.bidDepth + context.stats.askDepth << " traded " << context.stats.totalTradedQuantity << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // --replay [path] [--paced] [--counters]: reproduce a recorded session instead of running one
+    if (argc > 1 && string(argv[1]) == "--replay") {
+        string path = INPUT_JOURNAL_PATH;
+        bool paced = false;
+        bool counters = false;
+        for (int i = 2; i < argc; ++i) {
+            if (string(argv[i]) == "--paced") paced = true;
+            else if (string(argv[i]) == "--counters") counters = true;
+            else path = argv[i];
+        }
+        return runReplay(path, paced, counters);
+    }
+    // --sweep [path] [--threads n]: backtest strategy settings against a recorded session
+    if (argc > 1 && string(argv[1]) == "--sweep") {
+        string path = INPUT_JOURNAL_PATH;
+        size_t threads = 0;
+        for (int i = 2; i < argc; ++i) {
+            if (string(argv[i]) == "--threads" && i + 1 < argc) threads = strtoul(argv[++i], nullptr, 10);
+            else path = argv[i];
+        }
+        return runSweep(path, threads);
+    }
+    // --sharded [shards] [--ticks n] [--pin]: run the sharded simulator alone, one thread per shard
+    if (argc > 1 && string(argv[1]) == "--sharded") {
+        size_t shards = max(thread::hardware_concurrency(), 1u);
+        int ticks = 1000;
+        bool pin = false;
+        for (int i = 2; i < argc; ++i) {
+            if (string(argv[i]) == "--ticks" && i + 1 < argc) ticks = atoi(argv[++i]);
+            else if (string(argv[i]) == "--pin") pin = true;
+            else shards = strtoul(argv[i], nullptr, 10);
+        }
+        return runSharded(shards, ticks, pin);
+    }
+    // --agents: the simulator sends the default agent population's flow instead of one order
+    // per asset and tick
+    bool agentFlow = false;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--agents") agentFlow = true;
+    }
+
+    // 1) Create BankAccount and Portfolio
+    Ledger ledger(ASSETS.size());
+    uint32_t userAccountId = ledger.addAccount(100000.0);
+    BankAccount userAccount(ledger, userAccountId, "USD");
+    Portfolio userPortfolio(ledger, userAccountId);
+
+    // 2) Restore the engine from the last checkpoint, or generate and load initial orders
+    string csvPath = "transactions.csv";
     OrderBookManager manager(csvPath);
+    InputJournal inputJournal(INPUT_JOURNAL_PATH);
+    manager.attachInputJournal(&inputJournal);
+    g_inputJournal = &inputJournal;
+    BarAggregator bars;
+    manager.addExecutionListener([&bars](const string& asset, const Execution& execution) {
+        bars.onExecution(asset, execution);
+    });
+    g_bars = &bars;
+    CheckpointInfo checkpoint;
+    bool restored = restoreCheckpoint(CHECKPOINT_PATH, manager, userPortfolio, userAccount, &checkpoint);
+
     try {
-        manager.loadOrders();
-        manager.processOrders();
+        if (restored) {
+            lock_guard<mutex> lock(g_consoleMutex);
+            cout << "Restored " << checkpoint.assetCount << " books (" << checkpoint.levelCount
+                 << " levels) from " << CHECKPOINT_PATH << "\n";
+        } else {
+            int nbAssets = 3;
+            vector<int>    nbOrders     {100, 150, 200};
+            vector<double> prices       {150.0, 650.0, 300.0};
+            vector<double> shortRatios  {0.1,  0.2,  0.15};
+            generateOrdersAndReturn(nbAssets, nbOrders, prices, shortRatios, csvPath);
+
+            // The generated book opens like an exchange: one call auction at a single price,
+            // with reading, parsing and each asset's book building spread over every core.
+            manager.setUncrossMode(UncrossMode::Auction);
+            PipelineExecutor pipeline;
+            if (!pipeline.run(csvPath, manager)) {
+                throw runtime_error("could not load every order from " + csvPath);
+            }
+            lock_guard<mutex> lock(g_consoleMutex);
+            pipeline.report(cout);
+        }
         {
             lock_guard<mutex> lock(g_consoleMutex);
             cout << "\nInitial Order Book:\n";
@@ -81,14 +245,60 @@ int main() {
         return 1;
     }
 
-    // 3) Create BankAccount and Portfolio
-    BankAccount userAccount(100000.0, "USD");
-    Portfolio userPortfolio;
+    // 3) Replay account activity journaled after the checkpoint, then keep journaling to the same file
+    const string journalPath = "lob_journal.bin";
+    {
+        JournalReader previousSession(journalPath);
+        if (previousSession.isOpen() && previousSession.size() > checkpoint.journalRecords) {
+            previousSession.rebuild(userPortfolio, userAccount, checkpoint.journalRecords);
+        }
+    }
+    Journal journal(journalPath);
+    userAccount.attachJournal(&journal);
+    userPortfolio.attachJournal(&journal);
+
+    PreTradeRisk riskGate(userAccount);
+    for (size_t i = 0; i < ASSETS.size(); ++i) {
+        riskGate.setPosition(static_cast<int>(i), userPortfolio.getQuantity(ASSETS[i]));
+    }
+    for (const auto& [asset, stats] : manager.getStatistics()) {
+        riskGate.onStatisticsUpdate(asset, stats);
+    }
+    manager.addStatisticsListener([&riskGate](const string& asset, const OrderBookStatistics& stats) {
+        riskGate.onStatisticsUpdate(asset, stats);
+    });
+
+    for (const auto& [asset, stats] : manager.getStatistics()) {
+        userPortfolio.onStatisticsUpdate(asset, stats);
+    }
+    manager.addStatisticsListener([&userPortfolio](const string& asset, const OrderBookStatistics& stats) {
+        userPortfolio.onStatisticsUpdate(asset, stats);
+    });
+
+    // Local dashboards read books and statistics from shared memory (see MarketDataReader).
+    MarketDataPublisher marketData;
+    marketData.attach(manager);
+
+    // Strategy processes enter binary orders through the gateway (protocol in OrderGateway.h).
+    GatewayConfig gatewayConfig;
+    OrderGateway gateway(manager, gatewayConfig);
+    if (gateway.start()) {
+        lock_guard<mutex> lock(g_consoleMutex);
+        cout << "Order gateway listening on " << gatewayConfig.unixPath << "\n";
+    }
+
+    // Sized for a menu refresh rather than the default batch run.
+    MonteCarloConfig riskConfig;
+    riskConfig.scenarios = 50000;
+    MonteCarloRisk portfolioRisk(riskConfig);
+    vector<string> riskAssets;
+    vector<double> riskQuantities, riskPrices;
 
     // 4) Set up global pointers for the console handler
     g_userAccount   = &userAccount;
     g_userPortfolio = &userPortfolio;
     g_manager       = &manager;
+    g_journal       = &journal;
 
     // 5) Set the console control handler
     if (!SetConsoleCtrlHandler(ConsoleHandler, TRUE)) {
@@ -99,6 +309,7 @@ int main() {
 
     // 6) Create the simulator and run it in a background thread
     OrderBookSimulator simulator(manager);
+    if (agentFlow) simulator.addDefaultPopulation();
     thread simThread([&simulator]() {
         simulator.simulateRealtime(3600); 
     });
@@ -115,6 +326,9 @@ int main() {
     // 8) Main user loop
     while (true) {
         {
+            // The engine mutex comes first wherever both are held. It also covers the portfolio
+            // and the risk gate, which the engine's listeners update.
+            lock_guard<mutex> engine(manager.getEngineMutex());
             lock_guard<mutex> lock(g_consoleMutex);
             cout << "\n===== Current Order Book =====" << endl;
             manager.displayOrderBooks();
@@ -125,7 +339,18 @@ int main() {
             cout << "\n----- Portfolio -----" << endl;
             userPortfolio.printHoldings();
             userPortfolio.printGlobalPnL();
-            userPortfolio.printAssetPerformance(manager.getStatistics());
+            userPortfolio.printAssetPerformance();
+            MonteCarloRisk::collectPositions(userPortfolio, manager.getStatistics(), riskAssets, riskQuantities,
+                                             riskPrices);
+        }
+        // The simulation runs on copies, without holding up the engine's other writers.
+        RiskEstimate risk = portfolioRisk.evaluate(riskAssets, riskQuantities, riskPrices);
+        {
+            lock_guard<mutex> lock(g_consoleMutex);
+            if (risk.valid) {
+                cout << "1-day 99% VaR: " << risk.valueAtRisk << " USD, expected shortfall: "
+                     << risk.expectedShortfall << " USD" << endl;
+            }
 
             cout << "\nWould you like to place a manual order? (y/n): ";
         }
@@ -142,10 +367,11 @@ int main() {
             string stock     = inputHandler.getStockSymbol();
             float price     = inputHandler.getFloatInput("Enter the price: ");
             float quantity  = inputHandler.getFloatInput("Enter the quantity: ");
+            lock_guard<mutex> engine(manager.getEngineMutex());
 
             // Build a new Order
             Order order;
-            order.id          = 9999;
+            order.id          = manager.allocateOrderId();
             order.asset       = stock;
             order.timestamp   = getCurrentDateTime();
             order.dateTime    = chrono::system_clock::now();
@@ -155,14 +381,36 @@ int main() {
             order.type        = orderType;
             order.isShortSell = false;
 
+            // Pre-trade risk gate runs before the order reaches the book, on the asset id
+            // resolved once here
+            int assetId = getAssetId(stock);
+            bool isBuy = (orderType == "BUY");
+            int64_t now = chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now().time_since_epoch()).count();
+            RiskResult riskResult = riskGate.check(assetId, isBuy, price, quantity, now);
+            if (riskResult != RiskResult::Accepted) {
+                lock_guard<mutex> lock(g_consoleMutex);
+                cout << "Order rejected by pre-trade risk: " << riskResultToString(riskResult) << endl;
+                continue;
+            }
+
+            // Pre-trade cost estimate from the depth index
+            FillEstimate estimate = manager.estimateFill(stock, isBuy, quantity);
+            if (estimate.filledQuantity > 0) {
+                lock_guard<mutex> lock(g_consoleMutex);
+                cout << "Estimated sweep: " << estimate.filledQuantity << " @ avg " << estimate.averagePrice
+                     << " (worst " << estimate.worstPrice << ", slippage " << estimate.slippage
+                     << ", impact " << estimate.impact * 100 << "%)\n";
+            }
+
             // Update the OrderBook
             manager.processNewOrder(order);
 
             // Update BankAccount and Portfolio
-            if (orderType == "BUY") {
-                processBuyOrder(userAccount, userPortfolio, stock, quantity, price);
-            } else {
-                processSellOrder(userAccount, userPortfolio, stock, quantity, price);
+            bool settled = isBuy ? processBuyOrder(userAccount, userPortfolio, stock, quantity, price)
+                                 : processSellOrder(userAccount, userPortfolio, stock, quantity, price);
+            if (settled) {
+                riskGate.onFill(assetId, isBuy, quantity, price);
             }
 
             // Show updated book for that stock (locked output)
@@ -176,7 +424,7 @@ int main() {
                 cout << "\n----- PORTFOLIO SUMMARY -----\n";
                 userPortfolio.printHoldings();
                 userPortfolio.printGlobalPnL();
-                userPortfolio.printAssetPerformance(manager.getStatistics());
+                userPortfolio.printAssetPerformance();
             }
         }
 
@@ -196,12 +444,16 @@ int main() {
         cout << "\nMain user loop finished. Waiting for simulator to end...\n";
     }
     simThread.join();
+    gateway.stop();
 
     // 10) Save final state
     manager.saveOrderBooks("output");
     userAccount.logTransactionsToCSV("bank_transactions.csv");
     userPortfolio.logTradesToCSV("portfolio_trades.csv");
     userPortfolio.logPnLHistoryToCSV("portfolio_pnl.csv");
+    saveCheckpoint(CHECKPOINT_PATH, manager, userPortfolio, userAccount, journal.size());
+    inputJournal.seal(manager);
+    bars.exportCSV("bars.csv");
 
     {
         lock_guard<mutex> lock(g_consoleMutex);